@@ -0,0 +1,52 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_H
+#define AVRCPP_BENCH_H
+#include <chrono>
+#include <cstdio>
+// Minimal timing harness for the host benchmarks. Nothing fancy - we just want
+// to compare implementations against each other on the same machine.
+namespace bench {
+    template<typename T>
+    inline void do_not_optimize(T const& value) {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    inline void clobber_memory() {
+        asm volatile("" : : : "memory");
+    }
+
+    inline void section(const char* name) {
+        printf("\n== %s ==\n", name);
+    }
+
+    /// Run fn `iterations` times and print the average time per iteration
+    template<typename F>
+    auto measure(const char* name, size_t iterations, F&& fn) -> double {
+        fn(); // warm up
+        auto begin = std::chrono::steady_clock::now();
+        for(size_t i = 0; i < iterations; i++)
+            fn();
+        auto end = std::chrono::steady_clock::now();
+        auto ns = std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(iterations);
+        printf("%-48s %12.1f ns/iter\n", name, ns);
+        return ns;
+    }
+}
+
+#endif
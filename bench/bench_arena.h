@@ -0,0 +1,93 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_ARENA_H
+#define AVRCPP_BENCH_ARENA_H
+#include <cstdint>
+#include <new>
+#include "bench.h"
+#include "../include/stl/arena.h"
+#include "../include/memory"
+#include "../include/vector"
+
+namespace bench {
+    /// One "message": a handful of temporaries of varying size, all dropped at the end of the iteration
+    template<typename Allocate, typename Release>
+    void parse_messages(size_t messages, Allocate&& allocate, Release&& release_all) {
+        constexpr size_t temporaries = 16;
+        void* blocks[temporaries];
+        uint32_t seed = 42;
+        for(size_t m = 0; m < messages; m++) {
+            for(auto& block : blocks) {
+                seed = seed * 1103515245u + 12345u;
+                block = allocate(static_cast<size_t>(((seed >> 8) & 63u) + 4));
+                do_not_optimize(block);
+            }
+            release_all(blocks, temporaries);
+        }
+    }
+
+    inline void arena_vs_new() {
+        section("arena vs operator new, 16 scratch blocks of 4-67 bytes per message (10k messages)");
+        constexpr size_t messages = 10000;
+        static unsigned char scratch[2048];
+        stl::arena frame_memory{scratch};
+        measure("operator new/delete", 20, []() {
+            parse_messages(messages, [](size_t n) { return ::operator new(n); },
+                           [](void** blocks, size_t count) {
+                for(size_t i = 0; i < count; i++)
+                    ::operator delete(blocks[i]);
+            });
+        });
+        measure("stl::arena, reset per message", 20, [&frame_memory]() {
+            parse_messages(messages, [&frame_memory](size_t n) { return frame_memory.allocate(n); },
+                           [&frame_memory](void**, size_t) { frame_memory.reset(); });
+        });
+        printf("arena high water %zu of %zu bytes, %zu failed allocations\n",
+               frame_memory.high_water(), frame_memory.size(), frame_memory.failed_allocation_count());
+    }
+
+    /// The same message loop with real containers: a temporary vector and a shared_ptr per message
+    inline void arena_backed_containers() {
+        section("temporary vector<int> (24 pushes) + shared_ptr per message, heap vs arena (10k messages)");
+        constexpr size_t messages = 10000;
+        static unsigned char scratch[1024];
+        stl::arena frame_memory{scratch};
+        measure("stl::vector + stl::make_shared", 20, []() {
+            for(size_t m = 0; m < messages; m++) {
+                stl::vector<int> fields;
+                for(int i = 0; i < 24; i++)
+                    fields.push_back(i);
+                auto header = stl::make_shared<int>(fields[3]);
+                do_not_optimize(header);
+            }
+        });
+        measure("arena_allocator vector + allocate_shared", 20, [&frame_memory]() {
+            for(size_t m = 0; m < messages; m++) {
+                stl::arena::scope frame{frame_memory};
+                stl::arena_allocator<int> alloc{frame_memory};
+                stl::vector<int, stl::growth::doubling, unsigned int, stl::arena_allocator<int>> fields{alloc};
+                for(int i = 0; i < 24; i++)
+                    fields.push_back(i);
+                auto header = stl::allocate_shared<int>(alloc, fields[3]);
+                do_not_optimize(header);
+            }
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,101 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_DEQUE_H
+#define AVRCPP_BENCH_DEQUE_H
+#include <deque>
+#include "bench.h"
+#include "../include/deque"
+
+namespace bench {
+    template<typename D>
+    void deque_push_back_n(size_t n) {
+        D d{};
+        for(size_t i = 0; i < n; i++)
+            d.push_back(static_cast<int>(i));
+        do_not_optimize(d.back());
+    }
+
+    template<typename D>
+    void deque_push_front_n(size_t n) {
+        D d{};
+        for(size_t i = 0; i < n; i++)
+            d.push_front(static_cast<int>(i));
+        do_not_optimize(d.front());
+    }
+
+    template<typename D>
+    void deque_fifo_n(size_t n) {
+        D d{};
+        for(size_t i = 0; i < n; i++) {
+            d.push_back(static_cast<int>(i));
+            if(i % 3 == 0)
+                d.pop_front();
+        }
+        do_not_optimize(d.front());
+    }
+
+    template<typename It>
+    auto sum_range(It first, It last) -> long {
+        long sum = 0;
+        for(; first != last; ++first)
+            sum += *first;
+        return sum;
+    }
+
+    inline void deque_iteration() {
+        section("deque iteration and size (100k ints)");
+        constexpr size_t n = 100000;
+        stl::deque<int> d{};
+        std::deque<int> sd{};
+        for(size_t i = 0; i < n; i++) {
+            d.push_back(static_cast<int>(i));
+            sd.push_back(static_cast<int>(i));
+        }
+        measure("stl::deque<int> iterator", 100, [&d]() { do_not_optimize(sum_range(d.begin(), d.end())); });
+        measure("stl::deque<int> compact_iterator", 100, [&d]() { do_not_optimize(sum_range(d.compact_begin(), d.compact_end())); });
+        measure("std::deque<int> iterator", 100, [&sd]() { do_not_optimize(sum_range(sd.begin(), sd.end())); });
+        measure("stl::deque<int> size() x1000", 1000, [&d]() {
+            size_t sum = 0;
+            for(int i = 0; i < 1000; i++) {
+                do_not_optimize(d);
+                sum += d.size();
+            }
+            do_not_optimize(sum);
+        });
+        // The old layout: the map, a size_t map size, two four-pointer iterators and the chunk cache
+        constexpr size_t old_sizeof = sizeof(int**) + sizeof(size_t) + 2 * sizeof(stl::deque<int>::iterator)
+                                      + sizeof(stl::deque<int>::chunk_cache_type);
+        printf("sizeof(stl::deque<int>) = %zu bytes (was %zu with four-pointer ends)\n", sizeof(stl::deque<int>), old_sizeof);
+        printf("sizeof(stl::deque<int, 10, uint8_t>) = %zu bytes\n", sizeof(stl::deque<int, 10, uint8_t>));
+        printf("sizeof(stl::deque<int>::iterator) = %zu, sizeof(stl::deque<int, 10, uint8_t>::compact_iterator) = %zu\n",
+               sizeof(stl::deque<int>::iterator), sizeof(stl::deque<int, 10, uint8_t>::compact_iterator));
+    }
+
+    inline void deque_growth() {
+        section("deque push 100k ints");
+        constexpr size_t n = 100000;
+        measure("stl::deque<int> push_back", 20, []() { deque_push_back_n<stl::deque<int>>(n); });
+        measure("std::deque<int> push_back", 20, []() { deque_push_back_n<std::deque<int>>(n); });
+        measure("stl::deque<int> push_front", 20, []() { deque_push_front_n<stl::deque<int>>(n); });
+        measure("std::deque<int> push_front", 20, []() { deque_push_front_n<std::deque<int>>(n); });
+        measure("stl::deque<int> push_back/pop_front", 20, []() { deque_fifo_n<stl::deque<int>>(n); });
+        measure("std::deque<int> push_back/pop_front", 20, []() { deque_fifo_n<std::deque<int>>(n); });
+    }
+}
+
+#endif
@@ -0,0 +1,73 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_DEQUE_CHUNKS_H
+#define AVRCPP_BENCH_DEQUE_CHUNKS_H
+#include "bench.h"
+#include "../include/deque"
+
+namespace bench {
+    template<size_t N>
+    struct payload { uint8_t bytes[N]; };
+
+    template<typename D>
+    void deque_chunk_config(const char* name) {
+        using T = typename D::value_type;
+        constexpr size_t n = 4096;
+        char label[96];
+        snprintf(label, sizeof(label), "  %-22s push_back", name);
+        measure(label, 200, []() {
+            D d{};
+            for(size_t i = 0; i < n; i++)
+                d.push_back(T{static_cast<uint8_t>(i)});
+            do_not_optimize(d.back());
+        });
+        D d{};
+        for(size_t i = 0; i < n; i++)
+            d.push_back(T{static_cast<uint8_t>(i)});
+        snprintf(label, sizeof(label), "  %-22s random access", name);
+        measure(label, 200, [&d]() {
+            size_t sum = 0;
+            for(size_t i = 0; i < n; i += 7)
+                sum += d.begin()[static_cast<ptrdiff_t>(i)].bytes[0];
+            do_not_optimize(sum);
+        });
+        constexpr size_t chunks = n / D::chunk_size + 1;
+        printf("  %-22s %zu elements/chunk (%zu bytes), %zu chunk allocations\n",
+               name, D::chunk_size, D::chunk_size * sizeof(T), chunks);
+    }
+
+    template<size_t N>
+    void deque_chunks_for_size() {
+        using T = payload<N>;
+        printf("sizeof(T) = %zu\n", sizeof(T));
+        deque_chunk_config<stl::deque<T>>("10 elements");
+        deque_chunk_config<stl::budget_deque<T, 64, false>>("64 bytes");
+        deque_chunk_config<stl::budget_deque<T, 64, true>>("64 bytes, pow2");
+        deque_chunk_config<stl::budget_deque<T, 512, true>>("512 bytes, pow2");
+    }
+
+    inline void deque_chunk_sizing() {
+        section("deque chunk sizing across element sizes (4096 elements)");
+        deque_chunks_for_size<1>();
+        deque_chunks_for_size<4>();
+        deque_chunks_for_size<16>();
+        deque_chunks_for_size<64>();
+    }
+}
+
+#endif
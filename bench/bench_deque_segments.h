@@ -0,0 +1,84 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_DEQUE_SEGMENTS_H
+#define AVRCPP_BENCH_DEQUE_SEGMENTS_H
+#include "bench.h"
+#include "../include/deque"
+
+namespace bench {
+    inline void deque_segmented_algorithms() {
+        section("deque segmented algorithms vs element-wise iteration (100k elements)");
+        constexpr size_t n = 100000;
+        stl::deque<int> d{};
+        stl::deque<uint8_t> bytes{};
+        stl::deque<uint8_t> bytes_dst{};
+        for(size_t i = 0; i < n; i++) {
+            d.push_back(static_cast<int>(i));
+            bytes.push_back(static_cast<uint8_t>(i));
+            bytes_dst.push_back(0);
+        }
+        measure("sum int, iterator loop", 100, [&d]() {
+            int sum = 0;
+            for(auto it = d.begin(); it != d.end(); ++it)
+                sum += *it;
+            do_not_optimize(sum);
+        });
+        measure("sum int, stl::accumulate", 100, [&d]() {
+            do_not_optimize(stl::accumulate(d.begin(), d.end(), 0));
+        });
+        measure("sum int, stl::for_each_segment", 100, [&d]() {
+            int sum = 0;
+            stl::for_each_segment(d.begin(), d.end(), [&sum](int* first, int* last) {
+                for(; first != last; ++first)
+                    sum += *first;
+            });
+            do_not_optimize(sum);
+        });
+        measure("fill uint8_t, iterator loop", 100, [&bytes]() {
+            for(auto it = bytes.begin(); it != bytes.end(); ++it)
+                *it = 0x55;
+            clobber_memory();
+        });
+        measure("fill uint8_t, stl::fill (memset)", 100, [&bytes]() {
+            stl::fill(bytes.begin(), bytes.end(), 0x55);
+            clobber_memory();
+        });
+        measure("copy uint8_t deque->deque, iterator loop", 100, [&bytes, &bytes_dst]() {
+            auto out = bytes_dst.begin();
+            for(auto it = bytes.begin(); it != bytes.end(); ++it, ++out)
+                *out = *it;
+            clobber_memory();
+        });
+        measure("copy uint8_t deque->deque, stl::copy (memmove)", 100, [&bytes, &bytes_dst]() {
+            stl::copy(bytes.begin(), bytes.end(), bytes_dst.begin());
+            clobber_memory();
+        });
+        measure("find int, iterator loop", 100, [&d]() {
+            auto it = d.begin();
+            for(; it != d.end(); ++it)
+                if(*it == static_cast<int>(n - 1))
+                    break;
+            do_not_optimize(*it);
+        });
+        measure("find int, stl::find", 100, [&d]() {
+            do_not_optimize(*stl::find(d.begin(), d.end(), static_cast<int>(n - 1)));
+        });
+    }
+}
+
+#endif
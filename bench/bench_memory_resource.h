@@ -0,0 +1,78 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_MEMORY_RESOURCE_H
+#define AVRCPP_BENCH_MEMORY_RESOURCE_H
+#include "bench.h"
+#include "../include/memory_resource"
+#include "../include/vector"
+#include "../include/deque"
+
+namespace bench {
+    template<typename Vector, typename... Args>
+    void fill_and_drop_vectors(size_t rounds, Args&&... args) {
+        for(size_t r = 0; r < rounds; r++) {
+            Vector v{args...};
+            for(int i = 0; i < 64; i++)
+                v.push_back(i);
+            do_not_optimize(v[63]);
+        }
+    }
+
+    template<typename Deque, typename... Args>
+    void fill_and_drop_deques(size_t rounds, Args&&... args) {
+        for(size_t r = 0; r < rounds; r++) {
+            Deque d{args...};
+            for(int i = 0; i < 64; i++)
+                d.push_back(i);
+            do_not_optimize(d.back());
+        }
+    }
+
+    inline void memory_resource_overhead() {
+        section("pmr vs plain containers, build and drop 64 ints (10k rounds)");
+        constexpr size_t rounds = 10000;
+        static unsigned char scratch[4096];
+        auto* heap = stl::pmr::new_delete_resource();
+        stl::pmr::unsynchronized_pool_resource pool{stl::pmr::pool_options{16, 512}};
+        stl::pmr::monotonic_buffer_resource monotonic{scratch, sizeof(scratch)};
+        measure("stl::vector<int>", 20, []() { fill_and_drop_vectors<stl::vector<int>>(rounds); });
+        measure("stl::pmr::vector<int> (new_delete_resource)", 20, [heap]() {
+            fill_and_drop_vectors<stl::pmr::vector<int>>(rounds, heap);
+        });
+        measure("stl::pmr::vector<int> (unsynchronized_pool)", 20, [&pool]() {
+            fill_and_drop_vectors<stl::pmr::vector<int>>(rounds, &pool);
+        });
+        measure("stl::pmr::vector<int> (monotonic, release/round)", 20, [&monotonic]() {
+            for(size_t r = 0; r < rounds; r++) {
+                fill_and_drop_vectors<stl::pmr::vector<int>>(1, &monotonic);
+                monotonic.release();
+            }
+        });
+        measure("stl::deque<int>", 20, []() { fill_and_drop_deques<stl::deque<int>>(rounds); });
+        measure("stl::pmr::deque<int> (new_delete_resource)", 20, [heap]() {
+            fill_and_drop_deques<stl::pmr::deque<int>>(rounds, stl::pmr::polymorphic_allocator<int>{heap});
+        });
+        measure("stl::pmr::deque<int> (unsynchronized_pool)", 20, [&pool]() {
+            fill_and_drop_deques<stl::pmr::deque<int>>(rounds, stl::pmr::polymorphic_allocator<int>{&pool});
+        });
+        printf("sizeof(stl::vector<int>) = %zu, sizeof(stl::pmr::vector<int>) = %zu\n",
+               sizeof(stl::vector<int>), sizeof(stl::pmr::vector<int>));
+    }
+}
+
+#endif
@@ -0,0 +1,68 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_POOL_ALLOCATOR_H
+#define AVRCPP_BENCH_POOL_ALLOCATOR_H
+#include <cstdint>
+#include <cstdlib>
+#include "bench.h"
+#include "../include/stl/pool_allocator.h"
+
+namespace bench {
+    /// Small objects with random sizes and lifetimes, the pattern that fragments a malloc heap:
+    /// keep `live` slots filled and keep replacing a random one.
+    template<typename Allocate, typename Deallocate>
+    auto churn(size_t rounds, Allocate&& allocate, Deallocate&& deallocate) -> size_t {
+        constexpr size_t live = 32;
+        void* slots[live] = {};
+        uint32_t seed = 12345;
+        uintptr_t low = UINTPTR_MAX, high = 0;
+        for(size_t i = 0; i < rounds; i++) {
+            seed = seed * 1103515245u + 12345u;
+            auto slot = (seed >> 16) % live;
+            auto size = static_cast<size_t>(((seed >> 8) & 31u) + 1);
+            deallocate(slots[slot]);
+            slots[slot] = allocate(size);
+            do_not_optimize(slots[slot]);
+            auto address = reinterpret_cast<uintptr_t>(slots[slot]);
+            low = address < low ? address : low;
+            high = address + size > high ? address + size : high;
+        }
+        for(auto* p : slots)
+            deallocate(p);
+        return high - low; // address span touched by the workload
+    }
+
+    inline void pool_allocator_churn() {
+        section("pool allocator vs malloc, random 1-32 byte alloc/free (100k ops, 32 live)");
+        constexpr size_t rounds = 100000;
+        using allocator = stl::size_class_allocator<stl::fixed_block_pool<4, 8>, stl::fixed_block_pool<8, 8>,
+                                                    stl::fixed_block_pool<16, 16>, stl::fixed_block_pool<32, 32>>;
+        static allocator pool{};
+        size_t malloc_span = 0, pool_span = 0;
+        measure("malloc/free", 20, [&malloc_span]() {
+            malloc_span = churn(rounds, [](size_t n) { return malloc(n); }, [](void* p) { free(p); });
+        });
+        measure("stl::size_class_allocator", 20, [&pool_span]() {
+            pool_span = churn(rounds, [](size_t n) { return pool.allocate(n); }, [](void* p) { pool.deallocate(p); });
+        });
+        printf("address span: malloc %zu bytes, pool %zu bytes (pool storage %zu bytes, %zu fallbacks)\n",
+               malloc_span, pool_span, sizeof(allocator), pool.fallback_count());
+    }
+}
+
+#endif
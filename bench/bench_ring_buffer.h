@@ -0,0 +1,74 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_RING_BUFFER_H
+#define AVRCPP_BENCH_RING_BUFFER_H
+#include "bench.h"
+#include "../include/deque"
+#include "../include/ring_buffer"
+
+namespace bench {
+    // Producer pushes a burst of samples, consumer drains it again - like an ISR feeding the main loop
+    template<typename Q>
+    void producer_consumer(Q& q, size_t rounds, size_t burst) {
+        uint32_t sum = 0;
+        for(size_t r = 0; r < rounds; r++) {
+            for(size_t i = 0; i < burst; i++)
+                q.push_back(static_cast<uint16_t>(i));
+            for(size_t i = 0; i < burst; i++) {
+                sum += q.front();
+                q.pop_front();
+            }
+        }
+        do_not_optimize(sum);
+    }
+
+    inline void ring_buffer_vs_deque() {
+        section("ring_buffer vs deque, producer/consumer of uint16_t samples (10k bursts of 24)");
+        constexpr size_t rounds = 10000;
+        constexpr size_t burst = 24;
+        measure("stl::deque<uint16_t>", 20, []() {
+            stl::deque<uint16_t> q{};
+            producer_consumer(q, rounds, burst);
+        });
+        measure("stl::ring_buffer<uint16_t, 32> (mask)", 20, []() {
+            stl::ring_buffer<uint16_t, 32> q{};
+            producer_consumer(q, rounds, burst);
+        });
+        measure("stl::ring_buffer<uint16_t, 30> (compare)", 20, []() {
+            stl::ring_buffer<uint16_t, 30> q{};
+            producer_consumer(q, rounds, burst);
+        });
+        measure("stl::ring_buffer<uint16_t, 32> push_n/pop_n", 20, []() {
+            stl::ring_buffer<uint16_t, 32> q{};
+            uint16_t in[burst] = {};
+            uint16_t out[burst] = {};
+            uint32_t sum = 0;
+            for(size_t r = 0; r < rounds; r++) {
+                in[0] = static_cast<uint16_t>(r);
+                q.push_n(in, burst);
+                q.pop_n(out, burst);
+                sum += out[0];
+            }
+            do_not_optimize(sum);
+        });
+        printf("sizeof(stl::ring_buffer<uint16_t, 32>) = %zu, sizeof(stl::deque<uint16_t>) = %zu (+ heap)\n",
+               sizeof(stl::ring_buffer<uint16_t, 32>), sizeof(stl::deque<uint16_t>));
+    }
+}
+
+#endif
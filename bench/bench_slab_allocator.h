@@ -0,0 +1,71 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_SLAB_ALLOCATOR_H
+#define AVRCPP_BENCH_SLAB_ALLOCATOR_H
+#include <cstdint>
+#include <cstdlib>
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+#include <malloc.h>
+#define AVRCPP_BENCH_HEAP_IN_USE() (mallinfo2().uordblks)
+#endif
+#include "bench.h"
+#include "../include/stl/slab_allocator.h"
+
+namespace bench {
+    /// What the sized operator delete backend does with small objects, against plain malloc.
+    /// Uses the header directly, since this binary replaces the global new/delete for heap tracking.
+    inline void slab_allocator_small_objects() {
+        section("2-8 byte objects: malloc vs header-less slabs with sized free (1000 live objects)");
+        constexpr size_t objects = 1000;
+        static void* live[objects];
+        auto size_of = [](size_t i) { return static_cast<size_t>(2 + i % 7); };
+        using slabs_t = stl::slab_allocator<8, 16>;
+        measure("malloc/free", 50, [size_of]() {
+            for(size_t i = 0; i < objects; i++)
+                live[i] = malloc(size_of(i));
+            do_not_optimize(live[objects - 1]);
+            for(size_t i = 0; i < objects; i++)
+                free(live[i]);
+        });
+        static slabs_t slabs{};
+        measure("stl::slab_allocator (sized deallocate)", 50, [size_of]() {
+            for(size_t i = 0; i < objects; i++)
+                live[i] = slabs.allocate(size_of(i));
+            do_not_optimize(live[objects - 1]);
+            for(size_t i = 0; i < objects; i++)
+                slabs.deallocate(live[i], size_of(i));
+        });
+        slabs.release();
+#ifdef AVRCPP_BENCH_HEAP_IN_USE
+        auto before = AVRCPP_BENCH_HEAP_IN_USE();
+        for(size_t i = 0; i < objects; i++)
+            live[i] = malloc(size_of(i));
+        auto with_malloc = AVRCPP_BENCH_HEAP_IN_USE() - before;
+        for(size_t i = 0; i < objects; i++)
+            free(live[i]);
+        before = AVRCPP_BENCH_HEAP_IN_USE();
+        for(size_t i = 0; i < objects; i++)
+            live[i] = slabs.allocate(size_of(i));
+        auto with_slabs = AVRCPP_BENCH_HEAP_IN_USE() - before;
+        printf("heap in use: malloc %zu bytes, slabs %zu bytes (%zu slabs)\n", with_malloc, with_slabs, slabs.slab_count());
+        slabs.release();
+#endif
+    }
+}
+
+#endif
@@ -0,0 +1,107 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_SMART_PTR_H
+#define AVRCPP_BENCH_SMART_PTR_H
+#include "bench.h"
+#include "../include/memory"
+#include "../include/vector"
+#include "../include/deque"
+
+namespace bench {
+    struct intrusive_payload : stl::intrusive_ref_counter<intrusive_payload> {
+        int value = 0;
+    };
+
+    struct intrusive_payload32 : stl::intrusive_ref_counter<intrusive_payload32, uint32_t> {
+        int value = 0;
+    };
+
+    template<typename P>
+    void copy_destroy_n(const P& source, size_t n) {
+        for(size_t i = 0; i < n; i++) {
+            P copy = source;
+            do_not_optimize(copy);
+        }
+    }
+
+    inline void smart_ptr_copy() {
+        section("smart pointer copy + destroy (1M copies)");
+        constexpr size_t n = 1000000;
+        auto shared = stl::make_shared<int>(1);
+        auto intrusive = stl::intrusive_ptr<intrusive_payload>{new intrusive_payload{}};
+        measure("stl::shared_ptr<int>", 20, [&shared]() { copy_destroy_n(shared, n); });
+        auto intrusive32 = stl::intrusive_ptr<intrusive_payload32>{new intrusive_payload32{}};
+        measure("stl::intrusive_ptr<payload> (uint8_t count)", 20, [&intrusive]() { copy_destroy_n(intrusive, n); });
+        // x86 stalls on reloading a byte counter it just wrote, AVR does not. Word sized counters show the host baseline
+        measure("stl::intrusive_ptr<payload> (uint32_t count)", 20, [&intrusive32]() { copy_destroy_n(intrusive32, n); });
+        printf("sizeof(stl::shared_ptr<int>) = %zu, sizeof(stl::intrusive_ptr<payload>) = %zu\n",
+               sizeof(stl::shared_ptr<int>), sizeof(stl::intrusive_ptr<intrusive_payload>));
+    }
+
+    template<typename Policy>
+    void policy_copy_destroy(const char* name, size_t n) {
+        auto source = stl::make_shared<int, Policy>(1);
+        measure(name, 20, [&source, n]() { copy_destroy_n(source, n); });
+    }
+
+    inline void shared_ptr_policies() {
+        section("shared_ptr reference count policies, copy + destroy (1M copies)");
+        constexpr size_t n = 1000000;
+        policy_copy_destroy<stl::ref_count::plain<uint8_t>>("plain<uint8_t>", n);
+        policy_copy_destroy<stl::ref_count::plain<uint16_t>>("plain<uint16_t>", n);
+        policy_copy_destroy<stl::ref_count::plain<uint32_t>>("plain<uint32_t>", n);
+        // There are no interrupts to mask on the host, this only shows the cost of the compiler barriers
+        policy_copy_destroy<stl::ref_count::interrupt_masked<uint8_t>>("interrupt_masked<uint8_t>", n);
+        policy_copy_destroy<stl::ref_count::atomic<uint32_t>>("atomic<uint32_t>", n);
+    }
+
+    // Hands n shared_ptrs from a vector to a deque and back. With Move the counters are never touched,
+    // otherwise every hop is a copy (increment) followed by dropping the source (decrement)
+    template<bool Move>
+    void shared_ptr_hops(stl::vector<stl::shared_ptr<int>>& items, stl::deque<stl::shared_ptr<int>>& queue) {
+        for(auto& item : items) {
+            if constexpr(Move) {
+                queue.push_back(stl::move(item));
+            } else {
+                queue.push_back(item);
+                item.reset();
+            }
+        }
+        items.clear();
+        while(!queue.empty()) {
+            if constexpr(Move) {
+                items.push_back(stl::move(queue.front()));
+            } else {
+                items.push_back(queue.front());
+            }
+            queue.pop_front();
+        }
+    }
+
+    inline void shared_ptr_moves() {
+        section("shared_ptr through a vector and a deque and back (1000 pointers)");
+        stl::vector<stl::shared_ptr<int>> items{};
+        stl::deque<stl::shared_ptr<int>> queue{};
+        for(int i = 0; i < 1000; i++)
+            items.push_back(stl::make_shared<int>(i));
+        measure("copy + reset", 1000, [&]() { shared_ptr_hops<false>(items, queue); });
+        measure("move", 1000, [&]() { shared_ptr_hops<true>(items, queue); });
+    }
+}
+
+#endif
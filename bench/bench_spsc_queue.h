@@ -0,0 +1,122 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_SPSC_QUEUE_H
+#define AVRCPP_BENCH_SPSC_QUEUE_H
+#include <mutex>
+#include <thread>
+#include "bench.h"
+#include "../include/deque"
+#include "../include/spsc_queue"
+
+namespace bench {
+    // The mutex stands in for the cli/sei section that guards a shared deque on the target
+    struct locked_deque {
+        std::mutex lock;
+        stl::deque<uint32_t> q;
+        auto push(uint32_t v) -> bool { std::lock_guard<std::mutex> g{lock}; q.push_back(v); return true; }
+        auto pop(uint32_t& v) -> bool {
+            std::lock_guard<std::mutex> g{lock};
+            if(q.empty())
+                return false;
+            v = q.front();
+            q.pop_front();
+            return true;
+        }
+    };
+
+    template<typename Q>
+    void stream(Q& q, uint32_t total) {
+        std::thread producer([&q, total]() {
+            for(uint32_t i = 0; i < total;)
+                if(q.push(i)) i++; else std::this_thread::yield();
+        });
+        uint32_t v = 0, sum = 0;
+        for(uint32_t received = 0; received < total;)
+            if(q.pop(v)) { sum += v; received++; } else std::this_thread::yield();
+        producer.join();
+        do_not_optimize(sum);
+    }
+
+    inline void stream_batched(stl::spsc_queue<uint32_t, 256>& q, uint32_t total) {
+        static constexpr size_t batch = 32;
+        std::thread producer([&q, total]() {
+            uint32_t buf[batch];
+            for(uint32_t i = 0; i < total;) {
+                for(uint32_t j = 0; j < batch; j++)
+                    buf[j] = i + j;
+                auto n = q.push_n(buf, stl::min<size_t>(batch, total - i));
+                if(n == 0) std::this_thread::yield();
+                i += static_cast<uint32_t>(n);
+            }
+        });
+        uint32_t buf[batch];
+        uint32_t sum = 0;
+        for(uint32_t received = 0; received < total;) {
+            auto n = q.pop_n(buf, batch);
+            if(n == 0) std::this_thread::yield();
+            for(size_t j = 0; j < n; j++)
+                sum += buf[j];
+            received += static_cast<uint32_t>(n);
+        }
+        producer.join();
+        do_not_optimize(sum);
+    }
+
+    inline void spsc_queue_throughput() {
+        constexpr uint32_t total = 1000000;
+        section("spsc_queue throughput, 1M uint32_t between two threads (ns per 1M)");
+        measure("mutex + stl::deque<uint32_t>", 5, []() {
+            locked_deque q{};
+            stream(q, total);
+        });
+        measure("stl::spsc_queue<uint32_t, 256> push/pop", 5, []() {
+            stl::spsc_queue<uint32_t, 256> q{};
+            stream(q, total);
+        });
+        measure("stl::spsc_queue<uint32_t, 256> push_n/pop_n(32)", 5, []() {
+            stl::spsc_queue<uint32_t, 256> q{};
+            stream_batched(q, total);
+        });
+    }
+
+    inline void spsc_queue_latency() {
+        // One element ping-pongs between two threads, so each iteration is a round trip through two queues
+        constexpr uint32_t round_trips = 10000;
+        section("spsc_queue latency, 10k round trips (ns per 10k)");
+        measure("stl::spsc_queue<uint32_t, 16> ping-pong", 5, []() {
+            stl::spsc_queue<uint32_t, 16> ping{};
+            stl::spsc_queue<uint32_t, 16> pong{};
+            std::thread echo([&]() {
+                uint32_t v = 0;
+                for(uint32_t i = 0; i < round_trips; i++) {
+                    while(!ping.pop(v)) std::this_thread::yield();
+                    while(!pong.push(v)) std::this_thread::yield();
+                }
+            });
+            uint32_t v = 0;
+            for(uint32_t i = 0; i < round_trips; i++) {
+                ping.push(i);
+                while(!pong.pop(v)) std::this_thread::yield();
+            }
+            echo.join();
+            do_not_optimize(v);
+        });
+    }
+}
+
+#endif
@@ -0,0 +1,57 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_VECTOR_GROWTH_H
+#define AVRCPP_BENCH_VECTOR_GROWTH_H
+#include "bench.h"
+#include "heap_tracker.h"
+#include "../include/vector"
+
+namespace bench {
+    template<typename Growth>
+    void vector_growth_policy(const char* name, unsigned int elements) {
+        heap_tracker::reset();
+        {
+            auto v = stl::vector<uint16_t, Growth>();
+            for(unsigned int i = 0; i < elements; i++)
+                v.push_back(static_cast<uint16_t>(i));
+            do_not_optimize(v.get());
+            printf("%-24s %6u elems: %4zu allocations, peak %6zu bytes, final capacity %6u\n",
+                   name, elements, heap_tracker::allocations, heap_tracker::peak_bytes, v.capacity());
+        }
+        char label[64];
+        snprintf(label, sizeof(label), "  push_back x%u (%s)", elements, name);
+        measure(label, 1000, [elements]() {
+            auto v = stl::vector<uint16_t, Growth>();
+            for(unsigned int i = 0; i < elements; i++)
+                v.push_back(static_cast<uint16_t>(i));
+            do_not_optimize(v.get());
+        });
+    }
+
+    inline void vector_growth() {
+        section("stl::vector growth policies (uint16_t elements)");
+        for(unsigned int elements : {150u, 1000u}) {
+            vector_growth_policy<stl::growth::doubling>("doubling", elements);
+            vector_growth_policy<stl::growth::one_and_half>("one_and_half", elements);
+            vector_growth_policy<stl::growth::fixed_step<16>>("fixed_step<16>", elements);
+            vector_growth_policy<stl::growth::exact_fit>("exact_fit", elements);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_BENCH_HEAP_TRACKER_H
+#define AVRCPP_BENCH_HEAP_TRACKER_H
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+// Replaces the global new/delete for the benchmark binary so we can report heap usage.
+// Every block is prefixed with a header holding its size, so live and peak bytes are
+// tracked even when the unsized operator delete is called.
+namespace bench {
+    struct heap_tracker {
+        static inline size_t allocations = 0;
+        static inline size_t live_bytes = 0;
+        static inline size_t peak_bytes = 0;
+        static void reset() {
+            allocations = 0;
+            live_bytes = 0;
+            peak_bytes = 0;
+        }
+    };
+    constexpr size_t heap_tracker_header = alignof(std::max_align_t);
+}
+
+auto operator new(size_t size) -> void* {
+    auto* p = static_cast<unsigned char*>(malloc(size + bench::heap_tracker_header));
+    if(p == nullptr)
+        throw std::bad_alloc{};
+    *reinterpret_cast<size_t*>(p) = size;
+    bench::heap_tracker::allocations++;
+    bench::heap_tracker::live_bytes += size;
+    if(bench::heap_tracker::live_bytes > bench::heap_tracker::peak_bytes)
+        bench::heap_tracker::peak_bytes = bench::heap_tracker::live_bytes;
+    return p + bench::heap_tracker_header;
+}
+auto operator new[](size_t size) -> void* {
+    return ::operator new(size);
+}
+void operator delete(void* ptr) noexcept {
+    if(ptr == nullptr)
+        return;
+    auto* p = static_cast<unsigned char*>(ptr) - bench::heap_tracker_header;
+    bench::heap_tracker::live_bytes -= *reinterpret_cast<size_t*>(p);
+    free(p);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    ::operator delete(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+#endif
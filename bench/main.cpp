@@ -0,0 +1,48 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#include "bench_vector_growth.h"
+#include "bench_deque.h"
+#include "bench_deque_chunks.h"
+#include "bench_deque_segments.h"
+#include "bench_ring_buffer.h"
+#include "bench_spsc_queue.h"
+#include "bench_smart_ptr.h"
+#include "bench_pool_allocator.h"
+#include "bench_arena.h"
+#include "bench_memory_resource.h"
+#include "bench_slab_allocator.h"
+
+int main() {
+    bench::vector_growth();
+    bench::deque_growth();
+    bench::deque_iteration();
+    bench::deque_chunk_sizing();
+    bench::deque_segmented_algorithms();
+    bench::ring_buffer_vs_deque();
+    bench::spsc_queue_throughput();
+    bench::spsc_queue_latency();
+    bench::smart_ptr_copy();
+    bench::shared_ptr_policies();
+    bench::shared_ptr_moves();
+    bench::pool_allocator_churn();
+    bench::arena_vs_new();
+    bench::arena_backed_containers();
+    bench::memory_resource_overhead();
+    bench::slab_allocator_small_objects();
+    return 0;
+}
@@ -17,6 +17,9 @@
  * */
 #ifndef AVRCPP_ALGORITHM_H
 #define AVRCPP_ALGORITHM_H
+#include "default_includes"
+#include "type_traits.h"
+#include "../utility"
 
 namespace stl {
     template<class T>
@@ -36,6 +39,141 @@ namespace stl {
         return (comp(a, b)) ? a : b;
     }
     // TODO: stl::max for initializer_lists
+
+    /// True for iterators over chunked storage (e.g. stl::deque) that provide a for_each_segment overload.
+    /// The algorithms below then run a tight loop over each contiguous chunk instead of paying for a
+    /// chunk boundary check on every increment.
+    template<typename It>
+    struct is_segmented_iterator : false_type {};
+
+    /// Call f(first, last) for every contiguous block of [first, last), with first and last being raw pointers.
+    /// A pointer range is a single block, deque iterators yield one block per chunk.
+    /// Usage:
+    /// stl::for_each_segment(d.begin(), d.end(), [](uint8_t* first, uint8_t* last) { uart_write(first, last - first); });
+    template<class T, class F>
+    void for_each_segment(T* first, T* last, F f) {
+        if(first != last)
+            f(first, last);
+    }
+
+    template<class It, class F>
+    auto for_each(It first, It last, F f) -> F {
+        if constexpr(is_segmented_iterator<It>::value) {
+            for_each_segment(first, last, [&f](auto* b, auto* e) {
+                for(; b != e; ++b)
+                    f(*b);
+            });
+        } else {
+            for(; first != last; ++first)
+                f(*first);
+        }
+        return f;
+    }
+
+    template<class T>
+    auto copy(const T* first, const T* last, T* out) -> T* {
+        auto n = static_cast<size_t>(last - first);
+        if constexpr(is_trivially_copyable<T>::value) {
+            memmove((void*)out, (const void*)first, n * sizeof(T));
+            return out + n;
+        } else {
+            for(; first != last; ++first, ++out)
+                *out = *first;
+            return out;
+        }
+    }
+
+    template<class T>
+    auto copy(T* first, T* last, T* out) -> T* {
+        return copy(static_cast<const T*>(first), static_cast<const T*>(last), out);
+    }
+
+    /// When the destination is segmented, the source has to be random access
+    template<class InputIt, class OutputIt>
+    auto copy(InputIt first, InputIt last, OutputIt out) -> OutputIt {
+        if constexpr(is_segmented_iterator<InputIt>::value) {
+            for_each_segment(first, last, [&out](auto* b, auto* e) {
+                out = copy(b, e, out);
+            });
+            return out;
+        } else if constexpr(is_segmented_iterator<OutputIt>::value) {
+            auto out_last = out + (last - first);
+            for_each_segment(out, out_last, [&first](auto* b, auto* e) {
+                auto n = e - b;
+                copy(first, first + n, b);
+                first += n;
+            });
+            return out_last;
+        } else {
+            for(; first != last; ++first, ++out)
+                *out = *first;
+            return out;
+        }
+    }
+
+    /// Byte sized trivially copyable elements are filled with memset
+    template<class T, class V>
+    void fill(T* first, T* last, const V& value) {
+        if constexpr(sizeof(T) == 1 && is_trivially_copyable<T>::value) {
+            T v = value;
+            memset((void*)first, *reinterpret_cast<const unsigned char*>(&v), static_cast<size_t>(last - first));
+        } else {
+            for(; first != last; ++first)
+                *first = value;
+        }
+    }
+
+    template<class It, class V>
+    void fill(It first, It last, const V& value) {
+        if constexpr(is_segmented_iterator<It>::value) {
+            for_each_segment(first, last, [&value](auto* b, auto* e) {
+                fill(b, e, value);
+            });
+        } else {
+            for(; first != last; ++first)
+                *first = value;
+        }
+    }
+
+    template<class It, class V>
+    auto find(It first, It last, const V& value) -> It {
+        if constexpr(is_segmented_iterator<It>::value) {
+            size_t skipped = 0;
+            bool found = false;
+            for_each_segment(first, last, [&](auto* b, auto* e) {
+                if(found)
+                    return;
+                auto* p = find(b, e, value);
+                skipped += static_cast<size_t>(p - b);
+                found = p != e;
+            });
+            return first + static_cast<ptrdiff_t>(skipped);
+        } else {
+            for(; first != last; ++first)
+                if(*first == value)
+                    return first;
+            return last;
+        }
+    }
+
+    template<class It, class T, class BinaryOp>
+    auto accumulate(It first, It last, T init, BinaryOp op) -> T {
+        if constexpr(is_segmented_iterator<It>::value) {
+            for_each_segment(first, last, [&](auto* b, auto* e) {
+                for(; b != e; ++b)
+                    init = op(stl::move(init), *b);
+            });
+        } else {
+            for(; first != last; ++first)
+                init = op(stl::move(init), *first);
+        }
+        return init;
+    }
+
+    template<class It, class T>
+    auto accumulate(It first, It last, T init) -> T {
+        return accumulate(first, last, stl::move(init), [](T a, const auto& b) { return a + b; });
+    }
 }
 
 #endif //AVRCPP_ALGORITHM_H
@@ -0,0 +1,84 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_ALLOCATOR_H
+#define AVRCPP_ALLOCATOR_H
+#include "default_includes"
+#include "type_traits.h"
+#include "../utility"
+
+namespace stl {
+    //// Allocators. The containers and smart pointers only need four things from an allocator A<T>:
+    ////  - value_type
+    ////  - auto allocate(size_t n) -> T*       storage for n objects, never nullptr (abort instead)
+    ////  - void deallocate(T* p, size_t n)     n is the same amount that was allocated
+    ////  - a converting constructor from A<U>, so node based users can rebind it to their own types
+    //// Stateful allocators (a handle to a pool or an arena) must also be equality comparable:
+    //// two allocators compare equal if one can free what the other allocated. Stateless allocators
+    //// are always considered equal and take up no space in the containers (empty base optimization).
+
+    /// The default allocator. Goes through the global (sized) operator new/delete
+    template<typename T>
+    struct allocator {
+        using value_type = T;
+
+        constexpr allocator() = default;
+        template<typename U>
+        constexpr allocator(const allocator<U>&) {}
+
+        auto allocate(size_t n) -> T* { return static_cast<T*>(::operator new(n * sizeof(T))); }
+        void deallocate(T* p, size_t n) { ::operator delete(p, n * sizeof(T)); }
+
+        template<typename U>
+        constexpr auto operator==(const allocator<U>&) const -> bool { return true; }
+        template<typename U>
+        constexpr auto operator!=(const allocator<U>&) const -> bool { return false; }
+    };
+
+    /// The same allocator template for another value type. A<T, Args...> becomes A<U, Args...>
+    template<typename Alloc, typename U>
+    struct allocator_rebind;
+    template<template<typename, typename...> class A, typename T, typename... Args, typename U>
+    struct allocator_rebind<A<T, Args...>, U> { using type = A<U, Args...>; };
+    template<typename Alloc, typename U>
+    using allocator_rebind_t = typename allocator_rebind<Alloc, U>::type;
+
+    template<typename A, typename B>
+    constexpr auto _allocators_equal(const A& a, const B& b) -> bool {
+        if constexpr(stl::is_empty<A>::value)
+            return true;
+        else
+            return a == b;
+    }
+
+    /// Holds an allocator for a container. Stateless allocators are folded away through the empty base optimization
+    template<typename A, bool = stl::is_empty<A>::value && !stl::is_final<A>::value>
+    struct _allocator_holder : private A {
+        constexpr _allocator_holder(const A& a) : A(a) {}
+        auto alloc() -> A& { return *this; }
+        auto alloc() const -> const A& { return *this; }
+    };
+    template<typename A>
+    struct _allocator_holder<A, false> {
+        A a;
+        constexpr _allocator_holder(const A& a) : a(a) {}
+        auto alloc() -> A& { return a; }
+        auto alloc() const -> const A& { return a; }
+    };
+}
+
+#endif
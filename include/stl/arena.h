@@ -0,0 +1,140 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_ARENA_H
+#define AVRCPP_ARENA_H
+#include "default_includes"
+
+namespace stl {
+    /// Monotonic (bump) allocator over a caller supplied buffer. Allocating is a pointer bump, freeing a single
+    /// block does nothing - memory is handed back in bulk by rewinding to a checkpoint or resetting the arena.
+    /// Meant for scratch memory with a clear lifetime, like everything built while handling one message.
+    /// Usage:
+    /// static unsigned char scratch[256];
+    /// stl::arena frame_memory{scratch};
+    /// while(true) {
+    ///     stl::arena::scope frame{frame_memory}; // everything allocated in this iteration is gone at the }
+    ///     auto* msg = frame_memory.allocate(sizeof(message));
+    /// }
+    class arena {
+    public:
+        /// A position in the arena to rewind to
+        using marker = size_t;
+        static constexpr size_t default_alignment = __BIGGEST_ALIGNMENT__;
+
+        arena(void* buffer, size_t bytes)
+         : buffer{static_cast<unsigned char*>(buffer)}, top{0}, capacity{bytes}, peak{0}, allocations{0}, failures{0} {}
+        template<size_t N>
+        explicit arena(unsigned char (&buffer)[N]) : arena(buffer, N) {}
+        arena(const arena&) = delete;
+        auto operator=(const arena&) -> arena& = delete;
+
+        /// `bytes` bytes aligned to `alignment` (must be a power of two), or nullptr if the arena is exhausted
+        auto allocate(size_t bytes, size_t alignment = default_alignment) -> void* {
+            auto address = reinterpret_cast<uintptr_t>(buffer + top);
+            auto padding = static_cast<size_t>((~address + 1) & (alignment - 1));
+            if(padding + bytes > capacity - top) {
+                failures++;
+                return nullptr;
+            }
+            top += padding + bytes;
+            if(top > peak)
+                peak = top;
+            allocations++;
+            return buffer + top - bytes;
+        }
+        /// Single blocks are never given back, see rewind() and reset()
+        void deallocate(void*, size_t = 0) {}
+
+        auto checkpoint() const -> marker { return top; }
+        /// Release everything allocated since `m` was taken
+        void rewind(marker m) {
+#ifdef AVRCPP_DEBUG
+            if(m > top)
+                abort(); // the arena has already been rewound past this checkpoint
+#endif
+            top = m;
+        }
+        void reset() { top = 0; }
+        auto owns(const void* p) const -> bool {
+            auto* c = static_cast<const unsigned char*>(p);
+            return c >= buffer && c < buffer + capacity;
+        }
+
+        //// Statistics
+        auto used() const -> size_t { return top; }
+        auto remaining() const -> size_t { return capacity - top; }
+        auto size() const -> size_t { return capacity; }
+        /// Most bytes ever in use at once (including alignment padding). A good hint for sizing the buffer
+        auto high_water() const -> size_t { return peak; }
+        auto allocation_count() const -> size_t { return allocations; }
+        /// Amount of requests that did not fit
+        auto failed_allocation_count() const -> size_t { return failures; }
+
+        /// Takes a checkpoint on construction and rewinds to it on destruction
+        class scope {
+        public:
+            explicit scope(arena& a) : owner{a}, mark{a.checkpoint()} {}
+            scope(const scope&) = delete;
+            auto operator=(const scope&) -> scope& = delete;
+            ~scope() { owner.rewind(mark); }
+        private:
+            arena& owner;
+            marker mark;
+        };
+
+    private:
+        unsigned char* buffer;
+        size_t top;
+        size_t capacity;
+        size_t peak;
+        size_t allocations;
+        size_t failures;
+    };
+
+    /// Typed allocator handle over an arena, so containers and smart pointers can draw from it.
+    /// It only holds a reference, copies (also to other value types) allocate from the same arena.
+    /// Running out of arena is treated like running out of heap: it aborts.
+    template<typename T>
+    class arena_allocator {
+    public:
+        using value_type = T;
+
+        explicit arena_allocator(arena& a) : source{&a} {}
+        template<typename U>
+        arena_allocator(const arena_allocator<U>& o) : source{&o.resource()} {}
+
+        auto allocate(size_t n) -> T* {
+            auto* p = source->allocate(n * sizeof(T), alignof(T));
+            if(p == nullptr)
+                abort();
+            return static_cast<T*>(p);
+        }
+        void deallocate(T*, size_t) {}
+        auto resource() const -> arena& { return *source; }
+
+        template<typename U>
+        auto operator==(const arena_allocator<U>& o) const -> bool { return source == &o.resource(); }
+        template<typename U>
+        auto operator!=(const arena_allocator<U>& o) const -> bool { return !(*this == o); }
+
+    private:
+        arena* source;
+    };
+}
+
+#endif
@@ -0,0 +1,86 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_ATOMIC_H
+#define AVRCPP_ATOMIC_H
+#include "default_includes"
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#endif
+
+namespace stl {
+    /// Portable subset of the C++ memory orders.
+    /// Maps onto the GCC __atomic builtins, which avr-gcc and host gcc/clang both provide.
+    /// On AVR (single core, in-order) acquire/release only act as compiler barriers,
+    /// on the host they emit whatever fences the architecture needs.
+    enum class memory_order : int {
+        relaxed = __ATOMIC_RELAXED,
+        acquire = __ATOMIC_ACQUIRE,
+        release = __ATOMIC_RELEASE,
+        seq_cst = __ATOMIC_SEQ_CST,
+    };
+
+    /// The widest unsigned integer that the target can load and store in a single instruction.
+    /// AVR is an 8-bit machine, so anything wider can tear if an interrupt fires mid-access.
+#ifdef __AVR__
+    using lock_free_uint_t = uint8_t;
+#else
+    using lock_free_uint_t = size_t;
+#endif
+
+    template<typename T>
+    inline auto atomic_load(const T* src, memory_order order) -> T {
+        static_assert(sizeof(T) <= sizeof(lock_free_uint_t), "T cannot be loaded atomically on this target");
+        return __atomic_load_n(src, static_cast<int>(order));
+    }
+
+    template<typename T>
+    inline void atomic_store(T* dst, T value, memory_order order) {
+        static_assert(sizeof(T) <= sizeof(lock_free_uint_t), "T cannot be stored atomically on this target");
+        __atomic_store_n(dst, value, static_cast<int>(order));
+    }
+
+    /// Keep the compiler from moving memory accesses across this point. Emits no instructions.
+    inline void compiler_barrier() {
+        asm volatile("" ::: "memory");
+    }
+
+    /// Critical section. Disables interrupts for the lifetime of the guard and restores the previous
+    /// interrupt state afterwards, so guards nest and are safe to use inside ISRs.
+    /// Hosted builds have no interrupts to mask, there the guard is only a compiler barrier.
+    /// Usage:
+    /// { stl::interrupt_guard guard{}; shared_counter++; }
+    class interrupt_guard {
+    public:
+#ifdef __AVR__
+        interrupt_guard() : sreg{SREG} { cli(); }
+        ~interrupt_guard() { SREG = sreg; }
+#else
+        interrupt_guard() { compiler_barrier(); }
+        ~interrupt_guard() { compiler_barrier(); }
+#endif
+        interrupt_guard(const interrupt_guard&) = delete;
+        auto operator=(const interrupt_guard&) -> interrupt_guard& = delete;
+#ifdef __AVR__
+    private:
+        uint8_t sreg;
+#endif
+    };
+}
+
+#endif
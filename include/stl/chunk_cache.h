@@ -0,0 +1,117 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_CHUNK_CACHE_H
+#define AVRCPP_CHUNK_CACHE_H
+#include "default_includes"
+#include "allocator.h"
+#ifndef AVRCPP_DEFAULT_CHUNK_CACHE_LIMIT
+// Note: this is the amount of spare CHUNKS a cache keeps around - not byte size
+#define AVRCPP_DEFAULT_CHUNK_CACHE_LIMIT 1
+#endif
+
+namespace stl {
+    /// Chunk cache ownership for containers. owned_chunk_cache embeds a private cache in every container,
+    /// shared_chunk_cache only stores a pointer to a cache handed to the constructor
+    struct owned_chunk_cache {};
+    struct shared_chunk_cache {};
+
+    struct _free_chunk { _free_chunk* next; };
+    /// A chunk as the allocator sees it. Big enough to hold the free-list link, aligned for the elements
+    template<size_t chunk_bytes, size_t alignment>
+    struct _cache_chunk {
+        alignas(alignment > alignof(_free_chunk) ? alignment : alignof(_free_chunk))
+        unsigned char storage[chunk_bytes < sizeof(_free_chunk) ? sizeof(_free_chunk) : chunk_bytes];
+    };
+
+    /// Keeps up to `limit()` freed chunks of `chunk_bytes` around, so a container that keeps
+    /// crossing a chunk boundary doesn't have to go through the allocator every time.
+    /// The free chunks themselves hold the free-list, so the cache only costs a pointer and two counters.
+    /// A cache can be shared between several containers of the same chunk size.
+    /// Chunks come from Allocator and are aligned for its value_type.
+    template<size_t chunk_bytes, typename Allocator = stl::allocator<unsigned char>>
+    class chunk_cache : private _allocator_holder<allocator_rebind_t<Allocator,
+            _cache_chunk<chunk_bytes, alignof(typename Allocator::value_type)>>> {
+        using chunk = _cache_chunk<chunk_bytes, alignof(typename Allocator::value_type)>;
+        using chunk_allocator = allocator_rebind_t<Allocator, chunk>;
+        using free_chunk = _free_chunk;
+    public:
+        explicit chunk_cache(uint8_t limit = AVRCPP_DEFAULT_CHUNK_CACHE_LIMIT, const Allocator& allocator = Allocator{})
+         : _allocator_holder<chunk_allocator>{chunk_allocator{allocator}}, head{nullptr}, count{0}, max_count{limit} {}
+        chunk_cache(const chunk_cache&) = delete;
+        auto operator=(const chunk_cache&) -> chunk_cache& = delete;
+        ~chunk_cache() {
+            trim();
+        }
+
+        /// Get a chunk. Reuses a spare one if available, otherwise allocates a new one
+        auto acquire() -> void* {
+            if(head == nullptr)
+                return this->alloc().allocate(1);
+            auto* chunk = head;
+            head = head->next;
+            count--;
+            return chunk;
+        }
+
+        /// Give a chunk back. It is kept if there is room in the cache, otherwise it is freed
+        void release(void* chunk) {
+            if(chunk == nullptr)
+                return;
+            if(count >= max_count) {
+                deallocate(chunk);
+                return;
+            }
+            auto* c = static_cast<free_chunk*>(chunk);
+            c->next = head;
+            head = c;
+            count++;
+        }
+
+        /// Free all spare chunks
+        void trim() {
+            while(head != nullptr) {
+                auto* next = head->next;
+                deallocate(head);
+                head = next;
+            }
+            count = 0;
+        }
+
+        void set_limit(uint8_t limit) {
+            max_count = limit;
+            while(count > max_count) {
+                auto* next = head->next;
+                deallocate(head);
+                head = next;
+                count--;
+            }
+        }
+        auto limit() const -> uint8_t { return max_count; }
+        auto size() const -> uint8_t { return count; }
+        auto get_allocator() const -> Allocator { return Allocator{this->alloc()}; }
+
+    private:
+        void deallocate(void* c) { this->alloc().deallocate(static_cast<chunk*>(c), 1); }
+
+        free_chunk* head;
+        uint8_t count;
+        uint8_t max_count;
+    };
+}
+
+#endif //AVRCPP_CHUNK_CACHE_H
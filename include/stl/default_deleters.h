@@ -25,6 +25,10 @@ namespace stl {
 	//// by smart pointers.
 	template<typename T, typename SFINAE = void>
 	struct default_deleter {
+		default_deleter() = default;
+		/// Deleting through a base pointer, so unique_ptr<Derived> can be moved into unique_ptr<Base>
+		template<typename U>
+		default_deleter(const default_deleter<U>&) {}
 		static inline void free(T* a) { delete a; }
 	};
 
@@ -19,353 +19,679 @@
 #define AVRCPP_DEQUE_H
 #include "algorithm.h"
 #include "iterators.h"
+#include "chunk_cache.h"
+#include "type_traits.h"
+#include "uninitialized.h"
 #include "default_includes"
 #ifndef AVRCPP_DEFAULT_DEQUE_CHUNK_SIZE
 // Note: this is the ELEMENT AMOUNT in a deque buffer - not byte size
 #define AVRCPP_DEFAULT_DEQUE_CHUNK_SIZE 10
 #endif
+// Define AVRCPP_DEFAULT_DEQUE_CHUNK_BYTES to size the default deque chunks by a BYTE budget instead.
+// The element amount is then derived from sizeof(T) (and rounded down to a power of two).
 
 namespace stl {
-    template<typename T, size_t _deque_chunk_size = AVRCPP_DEFAULT_DEQUE_CHUNK_SIZE>
+    /// Elements per chunk for a deque<T> given a chunk budget in bytes. Always at least one element.
+    /// Rounding down to a power of two lets the deque iterators use shifts and masks instead of division.
+    template<typename T, size_t budget_bytes, bool round_to_power_of_two = true>
+    struct deque_chunk_elements {
+    private:
+        static constexpr size_t fit = budget_bytes / sizeof(T) == 0 ? 1 : budget_bytes / sizeof(T);
+        static constexpr size_t floor_power_of_two(size_t n) {
+            size_t p = 1;
+            while(p <= n / 2)
+                p <<= 1u;
+            return p;
+        }
+    public:
+        static constexpr size_t value = round_to_power_of_two ? floor_power_of_two(fit) : fit;
+    };
+
+    template<typename T>
+    constexpr size_t default_deque_chunk_size =
+#ifdef AVRCPP_DEFAULT_DEQUE_CHUNK_BYTES
+            deque_chunk_elements<T, AVRCPP_DEFAULT_DEQUE_CHUNK_BYTES>::value;
+#else
+            AVRCPP_DEFAULT_DEQUE_CHUNK_SIZE;
+#endif
+
+    /// Double ended queue made of fixed size chunks. The last template argument selects the integer
+    /// type used for sizes, pick uint8_t or uint16_t to shrink the container on small targets.
+    /// The map of chunk pointers is kept centered with free slots at both ends and grows geometrically,
+    /// so pushing across a chunk boundary is amortized O(1) and allocates exactly one chunk.
+    /// Freed chunks go through a small chunk_cache, so a deque that oscillates around a chunk
+    /// boundary (or is cleared and refilled) reuses its memory instead of going back to the allocator.
+    /// Every deque embeds its own cache. To share spare chunks between several deques instead, use
+    /// shared_chunk_cache as the last template argument (see shared_cache_deque) and pass the cache to the constructor.
+    /// Chunks and the map come from the Allocator (see allocator.h), the global heap by default.
+    /// The ends are stored as (chunk index, offset) pairs and the element count is cached, so the
+    /// deque itself stays small and size() is O(1). begin()/end() build the regular iterators on demand.
+    template<typename T, size_t _deque_chunk_size = default_deque_chunk_size<T>, typename SizeT = size_t,
+             typename Allocator = stl::allocator<T>, typename CacheOwnership = owned_chunk_cache>
     class deque {
+        static constexpr size_t initial_map_size = 3; // one node and a spare slot at either end
+        static constexpr bool shares_cache = stl::is_same<CacheOwnership, shared_chunk_cache>::value;
     public:
         using value_type = T;
         using map_pointer = value_type**;
         using reference = value_type&;
         using pointer = value_type*;
         using const_reference = const value_type&;
-        using size_type = size_t;
+        using size_type = SizeT;
+        using offset_type = stl::smallest_uint_t<_deque_chunk_size>;
         using iterator = _deque_iterator<value_type, _deque_chunk_size>;
+        using compact_iterator = _deque_compact_iterator<value_type, _deque_chunk_size, size_type, offset_type>;
+        using chunk_cache_type = chunk_cache<_deque_chunk_size * sizeof(value_type), Allocator>;
+        using allocator_type = Allocator;
+        static constexpr size_t chunk_size = _deque_chunk_size;
 
         deque();
-        deque(const deque<T,_deque_chunk_size>&);
+        explicit deque(const Allocator& allocator);
+        /// Only for shared_chunk_cache deques. Chunks come from (and go back to) shared_cache,
+        /// and the deque uses the cache's allocator
+        explicit deque(chunk_cache_type& shared_cache);
+        deque(const deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>&);
+        deque(deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>&&) noexcept;
         ~deque();
-        auto operator=(const deque<T,_deque_chunk_size>&) -> deque<T,_deque_chunk_size>&;
+        auto operator=(const deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>&) -> deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>&;
+        auto operator=(deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>&&) noexcept -> deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>&;
         inline auto size() const -> size_type;
         inline auto empty() const -> bool;
+        /// Pushing past this many elements aborts. SizeT also indexes the chunk map, so tiny chunks
+        /// with a narrow SizeT can run out of map slots (and abort) a few elements before that
+        static constexpr auto max_size() -> size_type { return static_cast<size_type>(~size_type{}); }
         auto begin() const -> iterator;
         auto end() const -> iterator;
+        auto compact_begin() const -> compact_iterator;
+        auto compact_end() const -> compact_iterator;
         auto front() -> reference;
         auto front() const -> const_reference;
         auto back() -> reference;
         auto back() const -> const_reference;
+        auto operator[](size_type index) -> reference;
+        auto operator[](size_type index) const -> const_reference;
+        /// Bounds checked element access. Aborts if index is out of range
+        auto at(size_type index) -> reference;
+        auto at(size_type index) const -> const_reference;
 
         void clear();
         void push_back(const_reference v);
+        void push_back(value_type&& v);
         template<typename... Args>
-        void emplace_back(Args... v);
+        void emplace_back(Args&&... args);
         void pop_back();
         void push_front(const_reference v);
+        void push_front(value_type&& v);
         template<typename... Args>
-        void emplace_front(Args... v);
+        void emplace_front(Args&&... args);
         void pop_front();
+        /// Insert/erase in the middle. Whichever side of the position is shorter gets shifted
+        auto insert(const iterator& pos, const_reference v) -> iterator;
+        auto insert(const iterator& pos, value_type&& v) -> iterator;
+        template<typename... Args>
+        auto emplace(const iterator& pos, Args&&... args) -> iterator;
+        template<typename... Args>
+        void emplace_index(size_type index, Args&&... args);
+        auto erase(const iterator& pos) -> iterator;
+        void erase_index(size_type index);
+        /// Shrink the map to what is currently in use, and release the spare chunks of an owned cache
+        void shrink_to_fit();
+        auto get_chunk_cache() -> chunk_cache_type&;
+        auto get_allocator() const -> Allocator { return chunks().get_allocator(); }
 #ifndef AVRCPP_DEBUG // Enable Unit tests to peek into the implementation for verification
     private:
 #endif
+        void initialize_map();
         auto allocate_map(size_type desired_size) -> map_pointer;
         void deallocate_map();
-        void copy_map_into(map_pointer other_map, size_t other_map_size) const;
-        void reverse_copy_map_into(map_pointer other_map, size_t other_map_size) const;
-        void extend_map(size_type nodes_to_add, bool add_at_front);
-        void shrink_map(size_type nodes_to_add, bool shrink_from_back);
+        void reserve_map_at_back(size_type nodes_to_add);
+        void reserve_map_at_front(size_type nodes_to_add);
+        void reallocate_map(size_type nodes_to_add, bool add_at_front);
         auto allocate_node() -> pointer;
+        void deallocate_node(pointer node);
         void push_back_auxiliary();
         void push_front_auxiliary();
-        void destroy_range(const iterator& a, const iterator& b) const;
-        void destroy_range(pointer a, pointer b);
+        void destroy_data();
+        void release_storage();
+        void steal(deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>& o);
+        using cache_member = stl::conditional_t<shares_cache, chunk_cache_type*, chunk_cache_type>;
+        /// A cache for a copy of o: its shared cache, or a fresh one with the same limit and allocator
+        static auto cache_like(const deque<T,_deque_chunk_size,SizeT,Allocator,CacheOwnership>& o) -> cache_member;
+        auto chunks() -> chunk_cache_type& {
+            if constexpr(shares_cache)
+                return *cache;
+            else
+                return cache;
+        }
+        auto chunks() const -> const chunk_cache_type& {
+            if constexpr(shares_cache)
+                return *cache;
+            else
+                return cache;
+        }
 
         map_pointer map;
+        cache_member cache;
         size_type map_size;
-        iterator start;
-        iterator finish;
+        size_type count;
+        size_type start_node;
+        size_type finish_node;
+        offset_type start_offset;
+        offset_type finish_offset;
     };
 
-    template<typename T, size_t deque_chunk_size>
-    deque<T, deque_chunk_size>::deque()
-     : map{nullptr}, map_size{}, start{nullptr}, finish{nullptr}
+    /// Deque taking its spare chunks from a chunk_cache shared with other deques of the same chunk size.
+    /// Usage:
+    /// stl::shared_cache_deque<int, 8>::chunk_cache_type spare_chunks{4};
+    /// stl::shared_cache_deque<int, 8> rx{spare_chunks}, tx{spare_chunks};
+    template<typename T, size_t chunk_size = default_deque_chunk_size<T>, typename SizeT = size_t,
+             typename Allocator = stl::allocator<T>>
+    using shared_cache_deque = deque<T, chunk_size, SizeT, Allocator, shared_chunk_cache>;
+
+    /// Deque whose chunks are sized by a byte budget rather than an element amount.
+    /// Usage:
+    /// stl::budget_deque<uint8_t, 32> rx_bytes; // 32 elements per chunk
+    /// stl::budget_deque<big_struct, 128> jobs;  // 128 / sizeof(big_struct) elements per chunk (at least one)
+    template<typename T, size_t budget_bytes, bool round_to_power_of_two = true, typename SizeT = size_t,
+             typename Allocator = stl::allocator<T>>
+    using budget_deque = deque<T, deque_chunk_elements<T, budget_bytes, round_to_power_of_two>::value, SizeT, Allocator>;
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deque()
+     : deque(Allocator{})
+    { }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deque(const Allocator& allocator)
+     : map{nullptr}, cache{AVRCPP_DEFAULT_CHUNK_CACHE_LIMIT, allocator}, map_size{}, count{},
+       start_node{}, finish_node{}, start_offset{}, finish_offset{}
     {
-        auto node0 = allocate_node();
-        map = allocate_map(1);
-        map[0] = node0;
-        map_size = 1;
-        start = iterator{map};
-        finish = iterator{map};
+        static_assert(!shares_cache, "a shared_chunk_cache deque must be given its cache");
+        initialize_map();
     }
 
-    template<typename T, size_t deque_chunk_size>
-    deque<T, deque_chunk_size>::deque(const deque<T, deque_chunk_size>& o)
-     : map{nullptr}, map_size{o.map_size}, start{o.start}, finish{o.finish}
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deque(chunk_cache_type& shared_cache)
+     : map{nullptr}, cache{&shared_cache}, map_size{}, count{},
+       start_node{}, finish_node{}, start_offset{}, finish_offset{}
     {
-        map = allocate_map(map_size);
-        o.copy_map_into(map, map_size);
-        start.set_node(&map[0]);
-        finish.set_node(&map[map_size-1]);
+        static_assert(shares_cache, "only shared_chunk_cache deques take a cache, see shared_cache_deque");
+        initialize_map();
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deque(const deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>& o)
+     : map{nullptr}, cache(cache_like(o)), map_size{}, count{},
+       start_node{}, finish_node{}, start_offset{}, finish_offset{}
+    {
+        initialize_map();
+        for(auto it = o.compact_begin(); it != o.compact_end(); ++it)
+            push_back(*it);
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::operator=(const deque<T, deque_chunk_size>& o) -> deque<T, deque_chunk_size> & {
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::operator=(const deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>& o) -> deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership> & {
         if(this == &o)
             return *this;
-        map_size = o.map_size;
-        start = o.start;
-        finish = o.finish;
-        map = allocate_map(map_size);
-        o.copy_map_into(map, map_size);
-        start.set_node(&map[0]);
-        finish.set_node(&map[map_size-1]);
+        clear();
+        for(auto it = o.compact_begin(); it != o.compact_end(); ++it)
+            push_back(*it);
         return *this;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    deque<T, deque_chunk_size>::~deque() {
-        clear();
-        for(size_type i = 0; i < map_size; i++)
-            free(map[i]);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deque(deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>&& o) noexcept
+     : map{nullptr}, cache(cache_like(o)), map_size{}, count{},
+       start_node{}, finish_node{}, start_offset{}, finish_offset{}
+    {
+        steal(o);
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::operator=(deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>&& o) noexcept -> deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership> & {
+        if(this == &o)
+            return *this;
+        if(!_allocators_equal(get_allocator(), o.get_allocator())) {
+            // o's chunks can not be freed through our allocator, so move the elements over instead
+            clear();
+            for(auto it = o.compact_begin(); it != o.compact_end(); ++it)
+                push_back(stl::move(*it));
+            o.clear();
+            return *this;
+        }
+        release_storage();
+        steal(o);
+        return *this;
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::steal(deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>& o) {
+        // Only the map changes owner. The elements and chunks stay exactly where they are
+        map = o.map;
+        map_size = o.map_size;
+        count = o.count;
+        start_node = o.start_node;
+        finish_node = o.finish_node;
+        start_offset = o.start_offset;
+        finish_offset = o.finish_offset;
+        // The moved-from deque is left empty and unallocated. It lazily gets a new map if it is reused
+        o.map = nullptr;
+        o.map_size = 0;
+        o.count = 0;
+        o.start_node = o.finish_node = 0;
+        o.start_offset = o.finish_offset = 0;
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::cache_like(const deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>& o) -> cache_member {
+        if constexpr(shares_cache)
+            return o.cache;
+        else
+            return chunk_cache_type{o.cache.limit(), o.get_allocator()};
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::release_storage() {
+        if(map == nullptr)
+            return;
+        destroy_data();
+        for(auto n = start_node; n <= finish_node; ++n)
+            deallocate_node(map[n]);
         deallocate_map();
+        map = nullptr;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::size() const -> size_type {
-        return finish - start;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::~deque() {
+        release_storage();
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::empty() const -> bool {
-        return finish == start;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::size() const -> size_type {
+        return count;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::begin() const -> iterator {
-        return start;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::empty() const -> bool {
+        return count == 0;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::end() const -> iterator {
-        return finish;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::begin() const -> iterator {
+        if(map == nullptr) // moved-from
+            return iterator{nullptr};
+        return iterator{map + start_node, map[start_node] + start_offset};
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::front() const -> const_reference {
-        return *start;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::end() const -> iterator {
+        if(map == nullptr) // moved-from
+            return iterator{nullptr};
+        return iterator{map + finish_node, map[finish_node] + finish_offset};
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::front() -> reference {
-        return *start;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::compact_begin() const -> compact_iterator {
+        return compact_iterator{map, start_node, start_offset};
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::back() const -> const_reference {
-        // Can't use *finish, and operator-- changes the iterator, so we need a cpy
-        // also can't use operator-(int) since that dereferences finish
-        auto tmp = finish;
-        return *(--tmp);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::compact_end() const -> compact_iterator {
+        return compact_iterator{map, finish_node, finish_offset};
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::back() -> reference {
-        // Can't use *finish, and operator-- changes the iterator, so we need a cpy
-        // also can't use operator-(int) since that dereferences finish
-        auto tmp = finish;
-        return *(--tmp);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::front() const -> const_reference {
+        return map[start_node][start_offset];
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::clear() {
-        if(empty())
-            return;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::front() -> reference {
+        return map[start_node][start_offset];
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::back() const -> const_reference {
+        if(finish_offset != 0)
+            return map[finish_node][finish_offset - 1];
+        return map[finish_node - 1][deque_chunk_size - 1];
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::back() -> reference {
+        if(finish_offset != 0)
+            return map[finish_node][finish_offset - 1];
+        return map[finish_node - 1][deque_chunk_size - 1];
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::operator[](size_type index) -> reference {
+        // Unsigned division by a constant. A shift and a mask for power-of-two chunks
+        auto absolute = static_cast<size_t>(start_offset) + index;
+        return map[start_node + absolute / deque_chunk_size][absolute % deque_chunk_size];
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::operator[](size_type index) const -> const_reference {
+        auto absolute = static_cast<size_t>(start_offset) + index;
+        return map[start_node + absolute / deque_chunk_size][absolute % deque_chunk_size];
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::at(size_type index) -> reference {
+        if(index >= count)
+            abort();
+        return (*this)[index];
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::at(size_type index) const -> const_reference {
+        if(index >= count)
+            abort();
+        return (*this)[index];
+    }
 
-        if(map_size > 2) { // Destroy all "middle" nodes
-            for(auto i = 1; i < map_size-1; i++)
-                destroy_range((pointer) map[i], (pointer) (map[i] + deque_chunk_size));
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::insert(const iterator& pos, const_reference v) -> iterator {
+        return emplace(pos, v);
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::insert(const iterator& pos, value_type&& v) -> iterator {
+        return emplace(pos, stl::move(v));
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    template<typename... Args>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::emplace(const iterator& pos, Args&&... args) -> iterator {
+        auto index = static_cast<size_type>(pos - begin());
+        emplace_index(index, stl::forward<Args>(args)...);
+        return begin() + index;
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    template<typename... Args>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::emplace_index(size_type index, Args&&... args) {
+        if(index == 0) {
+            emplace_front(stl::forward<Args>(args)...);
+            return;
+        }
+        if(index >= count) {
+            emplace_back(stl::forward<Args>(args)...);
+            return;
+        }
+        value_type v(stl::forward<Args>(args)...); // args may refer to one of our own elements
+        if(index < count / 2) {
+            // Shift the front part one step towards the front
+            emplace_front(stl::move(front()));
+            auto dst = compact_begin() + 1;
+            auto src = dst + 1;
+            for(size_type i = 1; i < index; ++i, ++dst, ++src)
+                *dst = stl::move(*src);
+            *dst = stl::move(v);
+        } else {
+            // Shift the back part one step towards the back
+            emplace_back(stl::move(back()));
+            auto dst = compact_end() - 2;
+            auto src = dst - 1;
+            for(size_type i = count - 2; i > index; --i, --dst, --src)
+                *dst = stl::move(*src);
+            *dst = stl::move(v);
         }
+    }
 
-        if(start.node != finish.node) { // Destroy "end" nodes
-            destroy_range(start.current, start.last);
-            destroy_range(finish.first, finish.current);
-        } else
-            destroy_range(start.current, finish.current);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::erase(const iterator& pos) -> iterator {
+        auto index = static_cast<size_type>(pos - begin());
+        erase_index(index);
+        return begin() + index;
+    }
 
-        // deallocate the map and the nodes
-        for(auto i = 0; i < map_size; i++)
-            free(map[i]);
-        deallocate_map();
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::erase_index(size_type index) {
+        if(index >= count)
+            return;
+        if(index < count / 2) {
+            // Close the gap by shifting the front part one step towards the back
+            auto dst = compact_begin() + index;
+            auto src = dst - 1;
+            for(size_type i = index; i > 0; --i, --dst, --src)
+                *dst = stl::move(*src);
+            pop_front();
+        } else {
+            // Close the gap by shifting the back part one step towards the front
+            auto dst = compact_begin() + index;
+            auto src = dst + 1;
+            for(size_type i = index; i + 1 < count; ++i, ++dst, ++src)
+                *dst = stl::move(*src);
+            pop_back();
+        }
+    }
 
-        map = allocate_map(1);
-        map[0] = allocate_node();
-        map_size = 1;
-        start = iterator{map};
-        finish = iterator{map};
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::clear() {
+        if(empty())
+            return;
+        destroy_data();
+        // Keep the map and the first node around, we are likely to be refilled
+        for(auto n = start_node + 1; n <= finish_node; ++n)
+            deallocate_node(map[n]);
+        finish_node = start_node;
+        finish_offset = start_offset;
+        count = 0;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::push_back(const_reference v) {
-        new(finish.current)value_type(v);
-        if(finish.current != finish.last - 1)
-            ++finish;
-        else
-            push_back_auxiliary();
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::push_back(const_reference v) {
+        emplace_back(v);
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::push_back(value_type&& v) {
+        emplace_back(stl::move(v));
     }
 
-    template<typename T, size_t deque_chunk_size>
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
     template<typename... Args>
-    void deque<T, deque_chunk_size>::emplace_back(Args... v) {
-        new(finish.current)value_type(v...);
-        if(finish.current != finish.last - 1)
-            ++finish;
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::emplace_back(Args&&... args) {
+        if(count == max_size()) // size_type is exhausted
+            abort();
+        if(map == nullptr) // moved-from
+            initialize_map();
+        new(map[finish_node] + finish_offset)value_type(stl::forward<Args>(args)...);
+        if(finish_offset != deque_chunk_size - 1)
+            ++finish_offset;
         else
             push_back_auxiliary();
+        ++count;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::pop_back() {
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::pop_back() {
         if(empty())
             return;
-        if(finish.current != finish.first) {
-            finish.current->~T();
-            --finish;
-        } else {
-            finish.current->~T();
-            free(finish.first);
-            shrink_map(1, true);
-            finish.current = finish.last-1;
+        if(finish_offset != 0)
+            --finish_offset;
+        else {
+            deallocate_node(map[finish_node]);
+            --finish_node;
+            finish_offset = deque_chunk_size - 1;
         }
+        if constexpr(!stl::is_trivially_destructible<T>::value)
+            map[finish_node][finish_offset].~T();
+        --count;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::pop_front() {
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::pop_front() {
         if(empty())
             return;
-        if(start.current != start.last - 1) {
-            start.current->~T();
-            ++start;
-        } else {
-            start.current->~T();
-            free(start.first);
-            shrink_map(1, false);
-            start.current = start.first;
+        if constexpr(!stl::is_trivially_destructible<T>::value)
+            map[start_node][start_offset].~T();
+        if(start_offset != deque_chunk_size - 1)
+            ++start_offset;
+        else {
+            deallocate_node(map[start_node]);
+            ++start_node;
+            start_offset = 0;
         }
+        --count;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::push_front(const_reference v) {
-        if(start.current != start.first)
-            --start;
-        else
-            push_front_auxiliary();
-        new(start.current)value_type(v);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::push_front(const_reference v) {
+        emplace_front(v);
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::push_front(value_type&& v) {
+        emplace_front(stl::move(v));
     }
 
-    template<typename T, size_t deque_chunk_size>
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
     template<typename... Args>
-    void deque<T, deque_chunk_size>::emplace_front(Args... v) {
-        if(start.current != start.first)
-            --start;
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::emplace_front(Args&&... args) {
+        if(count == max_size()) // size_type is exhausted
+            abort();
+        if(map == nullptr) // moved-from
+            initialize_map();
+        if(start_offset != 0)
+            --start_offset;
         else
             push_front_auxiliary();
-        new(start.current)value_type(v...);
+        new(map[start_node] + start_offset)value_type(stl::forward<Args>(args)...);
+        ++count;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::destroy_range(const iterator& a, const iterator& b) const {
-        for(auto p = a; p != b; ++p)
-            p.current->~T();
-    }
-
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::destroy_range(pointer a, pointer b) {
-        if(a == b)
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::destroy_data() {
+        if constexpr(stl::is_trivially_destructible<T>::value)
+            return;
+        if(start_node == finish_node) {
+            destroy_n(map[start_node] + start_offset, finish_offset - start_offset);
             return;
-        for(auto p = stl::min(a,b); p != stl::max(a,b); ++p)
-            p->~T();
+        }
+        destroy_n(map[start_node] + start_offset, deque_chunk_size - start_offset);
+        for(auto n = start_node + 1; n < finish_node; ++n) // Destroy all "middle" nodes
+            destroy_n(map[n], deque_chunk_size);
+        destroy_n(map[finish_node], finish_offset);
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::allocate_node() -> pointer {
-        return (pointer)malloc(deque_chunk_size * sizeof(value_type));
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::allocate_node() -> pointer {
+        return (pointer)chunks().acquire();
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::push_back_auxiliary() {
-        extend_map(1, false);
-        *(finish.node + 1) = allocate_node();
-        finish.set_node(finish.node + 1);
-        finish.current = finish.first;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deallocate_node(pointer node) {
+        chunks().release(node);
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::push_front_auxiliary() {
-        extend_map(1, true);
-        *(start.node - 1) = allocate_node();
-        start.set_node(start.node - 1);
-        start.current = start.last - 1;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::get_chunk_cache() -> chunk_cache_type& {
+        return chunks();
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::extend_map(size_type nodes_to_add, bool add_at_front) {
-        auto old_max_index = map_size == 0 ? 0 : map_size - 1;
-        auto new_map_size = map_size + nodes_to_add;
-        auto new_map = allocate_map(new_map_size);
-        for(auto i = 0; i < new_map_size; i++)
-            new_map[i] = allocate_node();
-        if(add_at_front)
-            reverse_copy_map_into(new_map, new_map_size);
-        else
-            copy_map_into(new_map, new_map_size);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::shrink_to_fit() {
+        if constexpr(!shares_cache)
+            cache.trim(); // a shared cache is left alone, other deques may be counting on its chunks
+        auto num_nodes = static_cast<size_t>(finish_node - start_node) + 1;
+        if(map_size <= num_nodes + 2)
+            return;
+        auto new_map_size = num_nodes + 2;
+        auto new_map = allocate_map(static_cast<size_type>(new_map_size));
+        memcpy(new_map + 1, map + start_node, num_nodes * sizeof(pointer));
         deallocate_map();
         map = new_map;
-        map_size = new_map_size;
+        map_size = static_cast<size_type>(new_map_size);
+        start_node = 1;
+        finish_node = static_cast<size_type>(num_nodes);
+    }
 
-        map_pointer new_node_start;
-        if(add_at_front)
-            new_node_start = &new_map[(new_map_size - 1) - old_max_index];
-        else
-            new_node_start = &new_map[0];
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::push_back_auxiliary() {
+        // Note: the element has already been constructed at the old finish position
+        reserve_map_at_back(1);
+        map[finish_node + 1] = allocate_node();
+        ++finish_node;
+        finish_offset = 0;
+    }
 
-        start.set_node(new_node_start);
-        finish.set_node(new_node_start + old_max_index);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::push_front_auxiliary() {
+        reserve_map_at_front(1);
+        map[start_node - 1] = allocate_node();
+        --start_node;
+        start_offset = deque_chunk_size - 1;
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::shrink_map(size_type nodes_to_shrink, bool shrink_from_back) {
-        auto new_map_size = map_size - nodes_to_shrink;
-        auto new_map = allocate_map(new_map_size);
-        if(shrink_from_back)
-            copy_map_into(new_map, new_map_size);
-        else
-            reverse_copy_map_into(new_map, new_map_size);
-        deallocate_map();
-        map = new_map;
-        map_size = new_map_size;
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::initialize_map() {
+        map_size = initial_map_size;
+        map = allocate_map(map_size);
+        start_node = (map_size - 1) / 2; // Start in the middle, so we can grow both ways
+        finish_node = start_node;
+        start_offset = 0;
+        finish_offset = 0;
+        count = 0;
+        map[start_node] = allocate_node();
+    }
+
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::reserve_map_at_back(size_type nodes_to_add) {
+        if(static_cast<size_t>(finish_node) + nodes_to_add >= map_size)
+            reallocate_map(nodes_to_add, false);
+    }
 
-        map_pointer new_node_start = &new_map[0];
-        start.set_node(new_node_start);
-        finish.set_node(new_node_start + new_map_size - 1);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::reserve_map_at_front(size_type nodes_to_add) {
+        if(nodes_to_add > start_node)
+            reallocate_map(nodes_to_add, true);
     }
 
-    template<typename T, size_t deque_chunk_size>
-    auto deque<T, deque_chunk_size>::allocate_map(size_type desired_size) -> map_pointer {
-        auto x = stl::max((size_type)1, desired_size) * sizeof(pointer);
-        return (map_pointer)malloc(x);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::reallocate_map(size_type nodes_to_add, bool add_at_front) {
+        // Only the node pointers move around - the nodes (and thus the elements) stay put
+        auto old_num_nodes = static_cast<size_t>(finish_node - start_node) + 1;
+        auto new_num_nodes = old_num_nodes + nodes_to_add;
+        size_t new_map_size = map_size + stl::max((size_t)map_size, (size_t)nodes_to_add) + 2;
+        if(new_map_size > max_size())
+            new_map_size = max_size();
+        if(new_map_size < new_num_nodes) // size_type can't index that many nodes
+            abort();
+        size_t new_start;
+        if(map_size > 2 * new_num_nodes || new_map_size == map_size) {
+            // Plenty of room (or no way to get more), the nodes are just lopsided. Re-center them in the current map
+            new_start = (map_size - new_num_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
+            memmove(map + new_start, map + start_node, old_num_nodes * sizeof(pointer));
+        } else {
+            auto new_map = allocate_map(static_cast<size_type>(new_map_size));
+            new_start = (new_map_size - new_num_nodes) / 2 + (add_at_front ? nodes_to_add : 0);
+            memcpy(new_map + new_start, map + start_node, old_num_nodes * sizeof(pointer));
+            deallocate_map();
+            map = new_map;
+            map_size = static_cast<size_type>(new_map_size);
+        }
+        start_node = static_cast<size_type>(new_start);
+        finish_node = static_cast<size_type>(new_start + old_num_nodes - 1);
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::deallocate_map() {
-        free(map);
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    auto deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::allocate_map(size_type desired_size) -> map_pointer {
+        return allocator_rebind_t<Allocator, pointer>{get_allocator()}.allocate(stl::max((size_type)1, desired_size));
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::copy_map_into(map_pointer other_map, size_t other_map_size) const {
-        for(auto i = 0; i < stl::min(map_size, other_map_size); i++)
-            other_map[i] = map[i];
+    template<typename T, size_t deque_chunk_size, typename SizeT, typename Allocator, typename CacheOwnership>
+    void deque<T, deque_chunk_size, SizeT, Allocator, CacheOwnership>::deallocate_map() {
+        allocator_rebind_t<Allocator, pointer>{get_allocator()}.deallocate(map, stl::max((size_type)1, map_size));
     }
 
-    template<typename T, size_t deque_chunk_size>
-    void deque<T, deque_chunk_size>::reverse_copy_map_into(map_pointer other_map, size_t other_map_size) const {
-        auto other_map_max_index = other_map_size - 1;
-        auto map_max_index = map_size - 1;
-        for(auto i = 0; i < stl::min(map_size, other_map_size); i++)
-            other_map[other_map_max_index - i] = map[map_max_index - i];
+    namespace pmr {
+        template<typename T> class polymorphic_allocator;
+        /// deque whose memory_resource is picked at run time (see memory_resource.h)
+        template<typename T, size_t chunk_size = default_deque_chunk_size<T>, typename SizeT = size_t>
+        using deque = stl::deque<T, chunk_size, SizeT, polymorphic_allocator<T>>;
     }
 }
 
@@ -0,0 +1,72 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_GROWTH_POLICY_H
+#define AVRCPP_GROWTH_POLICY_H
+#include "default_includes"
+
+namespace stl {
+    //// Growth policies decide the new capacity of a container that has run out of room.
+    //// A policy is any type with a static `next_capacity(current)` that returns something
+    //// larger than `current`. The container clamps the result to what its size_type can hold.
+    namespace growth {
+        /// Double the capacity. Few reallocations, but needs 3x the live data while relocating
+        struct doubling {
+            static constexpr auto next_capacity(size_t current) -> size_t {
+                return current == 0 ? 1 : current << 1u;
+            }
+        };
+
+        /// Grow by 50%. Gentler on small heaps, and freed blocks can eventually be reused
+        struct one_and_half {
+            static constexpr auto next_capacity(size_t current) -> size_t {
+                return current < 2 ? current + 1 : current + (current >> 1u);
+            }
+        };
+
+        /// Grow by a fixed amount of elements. Predictable memory use, linear reallocation count
+        template<size_t K>
+        struct fixed_step {
+            static_assert(K > 0, "fixed_step must grow by at least one element");
+            static constexpr auto next_capacity(size_t current) -> size_t {
+                return current + K;
+            }
+        };
+
+        /// Grow by exactly one element. No slack at all, but a reallocation on every push
+        struct exact_fit {
+            static constexpr auto next_capacity(size_t current) -> size_t {
+                return current + 1;
+            }
+        };
+    }
+
+    /// Capacity after `current` according to Growth, clamped to what SizeT can count.
+    /// Aborts once SizeT is exhausted and the container can't grow any further.
+    template<typename Growth, typename SizeT>
+    inline auto _next_capacity(SizeT current) -> SizeT {
+        constexpr auto max_size = static_cast<size_t>(static_cast<SizeT>(~SizeT{}));
+        auto next = Growth::next_capacity(current);
+        if(next > max_size)
+            next = max_size;
+        if(next <= current)
+            abort();
+        return static_cast<SizeT>(next);
+    }
+}
+
+#endif //AVRCPP_GROWTH_POLICY_H
@@ -0,0 +1,316 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_INPLACE_VECTOR_H
+#define AVRCPP_INPLACE_VECTOR_H
+#include "default_includes"
+#include "type_traits.h"
+#include "uninitialized.h"
+#include "../utility"
+
+namespace stl {
+    /// Fixed-capacity vector. All N elements live inside the object itself, so it never
+    /// touches the heap and its footprint is known at compile time: the element buffer plus
+    /// the smallest counter that can hold N.
+    /// Use try_push_back / try_emplace_back to detect overflow. The unchecked variants abort()
+    /// if the vector is full.
+    /// Usage:
+    /// stl::inplace_vector<uint8_t, 16> rx_bytes;
+    template<typename T, size_t N>
+    class inplace_vector {
+        static_assert(N > 0, "inplace_vector needs room for at least one element");
+    public:
+        using value_type = T;
+        using size_type = stl::smallest_uint_t<N>;
+        using iterator = T*;
+        using const_iterator = const T*;
+    private:
+        static constexpr size_t alignment = alignof(T) > alignof(size_type) ? alignof(T) : alignof(size_type);
+    public:
+        /// The exact sizeof(inplace_vector<T,N>), i.e. the buffer and counter rounded up to the stricter of their alignments
+        static constexpr size_t footprint = (N * sizeof(T) + sizeof(size_type) + alignment - 1) / alignment * alignment;
+
+        inplace_vector();
+        explicit inplace_vector(size_type size, const T& initial);
+        inplace_vector(const inplace_vector<T,N>& v);
+        inplace_vector(inplace_vector<T,N>&& v) noexcept;
+        ~inplace_vector();
+        static constexpr auto capacity() -> size_type { return N; }
+        auto size() const -> size_type;
+        auto empty() const -> bool;
+        auto full() const -> bool;
+        auto begin() -> iterator;
+        auto begin() const -> const_iterator;
+        auto end() -> iterator;
+        auto end() const -> const_iterator;
+        auto front() -> T&;
+        auto back() -> T&;
+        void push_back(const T& value);
+        void push_back(T&& value);
+        template<typename... Args>
+        void emplace_back(Args&&... args);
+        auto try_push_back(const T& value) -> bool;
+        auto try_push_back(T&& value) -> bool;
+        template<typename... Args>
+        auto try_emplace_back(Args&&... args) -> bool;
+        void erase(iterator pos);
+        void erase_index(size_type index);
+        void insert(iterator pos, const T& value);
+        auto try_insert(iterator pos, const T& value) -> bool;
+        void pop_back();
+        void resize(size_type size);
+        auto operator[](size_type index) -> T&;
+        auto operator[](size_type index) const -> const T&;
+        auto operator=(const inplace_vector<T,N>&) -> inplace_vector<T,N>&;
+        auto operator=(inplace_vector<T,N>&&) noexcept -> inplace_vector<T,N>&;
+        void clear();
+        auto get() const -> const T*;
+    private:
+        auto data() -> T*;
+        auto data() const -> const T*;
+
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+        size_type count;
+    };
+
+    template<typename T, size_t N>
+    using static_vector = inplace_vector<T, N>;
+
+    template<typename T, size_t N>
+    inplace_vector<T,N>::inplace_vector() : count{0} { }
+
+    template<typename T, size_t N>
+    inplace_vector<T,N>::inplace_vector(size_type size, const T& initial) : count{0} {
+        if(size > N)
+            abort();
+        uninitialized_fill_n(data(), size, initial);
+        count = size;
+    }
+
+    template<typename T, size_t N>
+    inplace_vector<T,N>::inplace_vector(const inplace_vector<T,N>& v) : count{v.count} {
+        uninitialized_copy_n(v.data(), v.count, data());
+    }
+
+    template<typename T, size_t N>
+    inplace_vector<T,N>::inplace_vector(inplace_vector<T,N>&& v) noexcept : count{v.count} {
+        uninitialized_relocate_n(v.data(), v.count, data());
+        v.count = 0;
+    }
+
+    template<typename T, size_t N>
+    inplace_vector<T,N>::~inplace_vector() {
+        static_assert(sizeof(inplace_vector<T,N>) == footprint, "inplace_vector must not carry more than its buffer and counter");
+        destroy_n(data(), count);
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::operator=(const inplace_vector<T,N>& v) -> inplace_vector<T,N>& {
+        if(&v == this)
+            return *this;
+        destroy_n(data(), count);
+        uninitialized_copy_n(v.data(), v.count, data());
+        count = v.count;
+        return *this;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::operator=(inplace_vector<T,N>&& v) noexcept -> inplace_vector<T,N>& {
+        if(&v == this)
+            return *this;
+        destroy_n(data(), count);
+        uninitialized_relocate_n(v.data(), v.count, data());
+        count = v.count;
+        v.count = 0;
+        return *this;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::data() -> T* {
+        return reinterpret_cast<T*>(buffer);
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::data() const -> const T* {
+        return reinterpret_cast<const T*>(buffer);
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::size() const -> size_type {
+        return count;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::empty() const -> bool {
+        return count == 0;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::full() const -> bool {
+        return count >= N;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::begin() -> iterator {
+        return data();
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::begin() const -> const_iterator {
+        return data();
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::end() -> iterator {
+        return data() + count;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::end() const -> const_iterator {
+        return data() + count;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::front() -> T& {
+        return data()[0];
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::back() -> T& {
+        return data()[count - 1];
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::push_back(T&& value) {
+        emplace_back(stl::move(value));
+    }
+
+    template<typename T, size_t N>
+    template<typename... Args>
+    void inplace_vector<T,N>::emplace_back(Args&&... args) {
+        if(!try_emplace_back(stl::forward<Args>(args)...))
+            abort();
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::try_push_back(const T& value) -> bool {
+        return try_emplace_back(value);
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::try_push_back(T&& value) -> bool {
+        return try_emplace_back(stl::move(value));
+    }
+
+    template<typename T, size_t N>
+    template<typename... Args>
+    auto inplace_vector<T,N>::try_emplace_back(Args&&... args) -> bool {
+        if(full())
+            return false;
+        new(data() + count) T(stl::forward<Args>(args)...);
+        count++;
+        return true;
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::pop_back() {
+        if(count <= 0)
+            return;
+        data()[--count].~T();
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::erase(iterator pos) {
+        if(pos >= end()) { // Erasing end() removes the last element, just like stl::vector
+            pop_back();
+            return;
+        }
+        for(auto i = pos; i + 1 != end(); ++i)
+            *i = stl::move(*(i + 1));
+        pop_back();
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::erase_index(size_type index) {
+        if(index < count)
+            erase(data() + index);
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::insert(iterator pos, const T& value) {
+        if(!try_insert(pos, value))
+            abort();
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::try_insert(iterator pos, const T& value) -> bool {
+        if(full())
+            return false;
+        auto index = static_cast<size_type>(pos - data());
+        if(index >= count)
+            return try_push_back(value);
+        T v = value; // value may be one of our own elements
+        auto* d = data();
+        new(d + count) T(stl::move(d[count - 1]));
+        for(auto i = count - 1; i > index; i--)
+            d[i] = stl::move(d[i - 1]);
+        d[index] = stl::move(v);
+        count++;
+        return true;
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::resize(size_type size) {
+        if(size > N)
+            abort();
+        if(size < count) {
+            destroy_n(data() + size, count - size);
+            count = size;
+            return;
+        }
+        for(; count < size; count++)
+            new(data() + count) T();
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::operator[](size_type index) -> T& {
+        return data()[index];
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::operator[](size_type index) const -> const T& {
+        return data()[index];
+    }
+
+    template<typename T, size_t N>
+    void inplace_vector<T,N>::clear() {
+        destroy_n(data(), count);
+        count = 0;
+    }
+
+    template<typename T, size_t N>
+    auto inplace_vector<T,N>::get() const -> const T* {
+        return data();
+    }
+}
+
+#endif //AVRCPP_INPLACE_VECTOR_H
@@ -0,0 +1,153 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef INTRUSIVE_PTR_HPP
+#define INTRUSIVE_PTR_HPP
+#include "default_includes"
+#include "type_traits.h"
+#include "ref_count.h"
+#include "../utility"
+
+namespace stl {
+    /// Intrusive pointer class. Shared ownership of objects that carry their own reference count,
+    /// so the handle is a single pointer and nothing besides the object is ever allocated.
+    /// The count is managed through two functions found by argument dependent lookup:
+    ///   void intrusive_add_ref(T* p);
+    ///   void intrusive_release(T* p); // destroy (or return to a pool) when the count drops to zero
+    /// Derive from intrusive_ref_counter to get both for free.
+    /// Usage:
+    /// struct message : stl::intrusive_ref_counter<message> { uint8_t payload[8]; };
+    /// stl::intrusive_ptr<message> msg{new message{}};
+    template<typename T>
+    class intrusive_ptr {
+        template<typename R>
+        using is_derived = stl::conditional_t<
+                stl::is_class<R>::value,
+                stl::is_base_of<T,R>,
+                stl::is_same<T,R>
+        >;
+        template<typename> friend class intrusive_ptr;
+    public:
+        intrusive_ptr() : resource(nullptr) {}
+        /// Takes a reference on p unless add_ref is false (adopting a reference that was already taken)
+        intrusive_ptr(T* p, bool add_ref = true) : resource(p) {
+            if(resource != nullptr && add_ref)
+                intrusive_add_ref(resource);
+        }
+        intrusive_ptr(const intrusive_ptr& ptr2) : intrusive_ptr(ptr2.resource) {}
+        template<typename R>
+        intrusive_ptr(const intrusive_ptr<R>& ptr2) : intrusive_ptr(static_cast<T*>(ptr2.resource)) {
+            static_assert(is_derived<R>::value, "Can only copy pointers of derived classes!");
+        }
+        intrusive_ptr(intrusive_ptr&& ptr2) noexcept : resource(ptr2.resource) {
+            ptr2.resource = nullptr;
+        }
+        template<typename R>
+        intrusive_ptr(intrusive_ptr<R>&& ptr2) noexcept : resource(static_cast<T*>(ptr2.resource)) {
+            static_assert(is_derived<R>::value, "Can only move pointers of derived classes!");
+            ptr2.resource = nullptr;
+        }
+        ~intrusive_ptr() {
+            if(resource != nullptr)
+                intrusive_release(resource);
+        }
+
+        auto operator=(const intrusive_ptr& ptr2) -> intrusive_ptr& {
+            intrusive_ptr(ptr2).swap(*this);
+            return *this;
+        }
+        template<typename R>
+        auto operator=(const intrusive_ptr<R>& ptr2) -> intrusive_ptr& {
+            intrusive_ptr(ptr2).swap(*this);
+            return *this;
+        }
+        auto operator=(intrusive_ptr&& ptr2) noexcept -> intrusive_ptr& {
+            intrusive_ptr(stl::move(ptr2)).swap(*this);
+            return *this;
+        }
+        template<typename R>
+        auto operator=(intrusive_ptr<R>&& ptr2) noexcept -> intrusive_ptr& {
+            intrusive_ptr(stl::move(ptr2)).swap(*this);
+            return *this;
+        }
+
+        inline T* operator->() const { return resource; }
+        inline T& operator*() const { return *resource; }
+        inline T* get() const { return resource; }
+        explicit operator bool() const { return resource != nullptr; }
+
+        void reset() {
+            intrusive_ptr().swap(*this);
+        }
+        void reset(T* p, bool add_ref = true) {
+            intrusive_ptr(p, add_ref).swap(*this);
+        }
+        /// Give up ownership without releasing the reference. The caller is now responsible for it
+        auto detach() -> T* {
+            auto* p = resource;
+            resource = nullptr;
+            return p;
+        }
+        void swap(intrusive_ptr& ptr2) noexcept {
+            auto* tmp = resource;
+            resource = ptr2.resource;
+            ptr2.resource = tmp;
+        }
+
+    private:
+        T* resource;
+    };
+
+    template<typename T, typename R>
+    inline auto operator==(const intrusive_ptr<T>& a, const intrusive_ptr<R>& b) -> bool { return a.get() == b.get(); }
+    template<typename T, typename R>
+    inline auto operator!=(const intrusive_ptr<T>& a, const intrusive_ptr<R>& b) -> bool { return a.get() != b.get(); }
+
+    /// Mixin that embeds the reference count in Derived and provides the intrusive_ptr hooks.
+    /// The count starts at zero, the first intrusive_ptr takes the first reference.
+    /// Objects are deleted when the last reference goes away. Pooled objects should
+    /// provide their own intrusive_release instead.
+    /// Pick CounterT to fit the amount of handles you expect, uint8_t holds up to 255 references.
+    /// Going past that wraps the count to zero, which aborts with AVRCPP_DEBUG defined.
+    template<typename Derived, typename CounterT = uint8_t>
+    class intrusive_ref_counter {
+    public:
+        auto use_count() const -> CounterT { return ref_count; }
+
+        friend void intrusive_add_ref(const Derived* p) {
+            auto& c = static_cast<const intrusive_ref_counter*>(p)->ref_count;
+            stl::ref_count::check_overflow(c);
+            ++c;
+        }
+        friend void intrusive_release(const Derived* p) {
+            if(--static_cast<const intrusive_ref_counter*>(p)->ref_count == 0)
+                delete p;
+        }
+
+    protected:
+        intrusive_ref_counter() : ref_count(0) {}
+        // Copies are new objects, they do not inherit the references of the original
+        intrusive_ref_counter(const intrusive_ref_counter&) : ref_count(0) {}
+        auto operator=(const intrusive_ref_counter&) -> intrusive_ref_counter& { return *this; }
+        ~intrusive_ref_counter() = default;
+
+    private:
+        mutable CounterT ref_count;
+    };
+}
+
+#endif // INTRUSIVE_PTR_HPP
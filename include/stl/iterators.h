@@ -16,6 +16,7 @@
  * original author: sillydan1 <https://github.com/sillydan1>
  * */
 #include "default_includes"
+#include "algorithm.h"
 
 namespace stl {
 #ifdef AVRCPP_DEQUE_H
@@ -28,6 +29,13 @@ namespace stl {
         using size_type = size_t;
         using self_type = _deque_iterator<value_type, max_elems_in_chunk>;
         using difference_type = ptrdiff_t;
+        static constexpr bool chunk_is_power_of_two = (max_elems_in_chunk & (max_elems_in_chunk - 1)) == 0;
+        static constexpr difference_type chunk_shift = [](){
+            difference_type s = 0;
+            while((static_cast<size_t>(1) << s) < max_elems_in_chunk)
+                s++;
+            return s;
+        }();
         pointer current;
         pointer first;
         pointer last;
@@ -39,6 +47,10 @@ namespace stl {
                 set_node(map);
             current = first;
         }
+        _deque_iterator(map_pointer map, pointer cur)
+         : current{cur}, first{*map}, last{*map + max_elems_in_chunk}, node{map} {
+
+        }
         _deque_iterator(const self_type & o)
          : current{o.current}, first{o.first}, last{o.last}, node{o.node} {
 
@@ -85,9 +97,14 @@ namespace stl {
         }
         auto operator+=(difference_type n) -> self_type& {
             auto offset = n + (current - first);
-            if (offset >= 0 && offset < max_elems_in_chunk)
+            if (offset >= 0 && offset < static_cast<difference_type>(max_elems_in_chunk))
                 current += n;
-            else {
+            else if constexpr(chunk_is_power_of_two) {
+                // Arithmetic shift floors towards negative infinity, so this also works when going backwards
+                auto node_offset = offset >> chunk_shift;
+                set_node(node + node_offset);
+                current = first + (offset & static_cast<difference_type>(max_elems_in_chunk - 1));
+            } else {
                 auto node_offset = offset > 0 ?
                                    offset / max_elems_in_chunk
                         : -((-offset - 1) / max_elems_in_chunk) - 1;
@@ -134,6 +151,113 @@ namespace stl {
         // TODO: <, <=, !=, ==, =>, > operators
     };
 
+    /// Compact deque iterator. Instead of four pointers it only carries the map, the index of the
+    /// chunk in the map and the offset into the chunk, using integer types chosen by the deque.
+    /// Cheaper to store and copy, but every dereference goes through the map.
+    template<typename T, size_t max_elems_in_chunk, typename index_type, typename offset_type>
+    struct _deque_compact_iterator {
+        using value_type = T;
+        using pointer = value_type*;
+        using map_pointer = value_type**;
+        using reference = value_type&;
+        using self_type = _deque_compact_iterator<value_type, max_elems_in_chunk, index_type, offset_type>;
+        using difference_type = ptrdiff_t;
+        map_pointer map;
+        index_type node;
+        offset_type offset;
+
+        _deque_compact_iterator(map_pointer map, index_type node, offset_type offset)
+         : map{map}, node{node}, offset{offset} {
+
+        }
+        auto operator*() const -> reference {
+            return map[node][offset];
+        }
+        auto operator->() const -> pointer {
+            return map[node] + offset;
+        }
+        auto operator++() -> self_type& {
+            if(++offset == max_elems_in_chunk) {
+                offset = 0;
+                ++node;
+            }
+            return *this;
+        }
+        auto operator++(int) -> self_type {
+            auto tmp = *this;
+            ++*this;
+            return tmp;
+        }
+        auto operator--() -> self_type& {
+            if(offset == 0) {
+                offset = max_elems_in_chunk;
+                --node;
+            }
+            --offset;
+            return *this;
+        }
+        auto operator--(int) -> self_type {
+            auto tmp = *this;
+            --*this;
+            return tmp;
+        }
+        auto operator+=(difference_type n) -> self_type& {
+            // Unsigned division by a constant. Becomes a shift and a mask for power-of-two chunks
+            auto absolute = static_cast<size_t>(static_cast<difference_type>(node * max_elems_in_chunk + offset) + n);
+            node = static_cast<index_type>(absolute / max_elems_in_chunk);
+            offset = static_cast<offset_type>(absolute % max_elems_in_chunk);
+            return *this;
+        }
+        auto operator+(difference_type n) const -> self_type {
+            auto tmp = *this;
+            return tmp += n;
+        }
+        auto operator-=(difference_type n) -> self_type& {
+            return *this += -n;
+        }
+        auto operator-(difference_type n) const -> self_type {
+            auto tmp = *this;
+            return tmp -= n;
+        }
+        auto operator-(const self_type& o) const -> difference_type {
+            return static_cast<difference_type>(max_elems_in_chunk) * (static_cast<difference_type>(node) - o.node)
+                   + (static_cast<difference_type>(offset) - o.offset);
+        }
+        auto operator[](difference_type n) const -> reference {
+            return *(this->operator+(n));
+        }
+        auto operator==(const self_type& o) const -> bool {
+            return node == o.node && offset == o.offset && map == o.map;
+        }
+        auto operator!=(const self_type& o) const -> bool {
+            return !(this->operator==(o));
+        }
+    };
+
+    template<typename T, size_t max_elems_in_chunk>
+    struct is_segmented_iterator<_deque_iterator<T, max_elems_in_chunk>> : true_type {};
+
+    template<typename T, size_t max_elems_in_chunk, typename index_type, typename offset_type>
+    struct is_segmented_iterator<_deque_compact_iterator<T, max_elems_in_chunk, index_type, offset_type>> : true_type {};
+
+    /// One call per chunk, the chunk boundary is only checked once per chunk
+    template<typename T, size_t max_elems_in_chunk, class F>
+    void for_each_segment(_deque_iterator<T,max_elems_in_chunk> first, _deque_iterator<T,max_elems_in_chunk> last, F f) {
+        for(; first.node != last.node; first.set_node(first.node + 1), first.current = first.first)
+            f(first.current, first.last);
+        if(first.current != last.current)
+            f(first.current, last.current);
+    }
+
+    template<typename T, size_t max_elems_in_chunk, typename index_type, typename offset_type, class F>
+    void for_each_segment(_deque_compact_iterator<T, max_elems_in_chunk, index_type, offset_type> first,
+                          _deque_compact_iterator<T, max_elems_in_chunk, index_type, offset_type> last, F f) {
+        for(; first.node != last.node; ++first.node, first.offset = 0)
+            f(first.map[first.node] + first.offset, first.map[first.node] + max_elems_in_chunk);
+        if(first.offset != last.offset)
+            f(first.map[first.node] + first.offset, first.map[first.node] + last.offset);
+    }
+
     template<typename T, size_t max_elems_in_chunk>
     auto operator==(const _deque_iterator<T,max_elems_in_chunk>& a, const _deque_iterator<T,max_elems_in_chunk>& b) {
         return a.operator==(b);
@@ -0,0 +1,303 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_MEMORY_RESOURCE_H
+#define AVRCPP_MEMORY_RESOURCE_H
+#include "default_includes"
+#ifndef AVRCPP_DEFAULT_MONOTONIC_BLOCK_SIZE
+// Note: the first block a monotonic_buffer_resource requests from upstream, in bytes. Later blocks double
+#define AVRCPP_DEFAULT_MONOTONIC_BLOCK_SIZE 64
+#endif
+
+namespace stl {
+    namespace pmr {
+        /// Run-time selected source of memory. Containers using a polymorphic_allocator all have the same type,
+        /// no matter if their memory comes from the heap, an arena or a pool.
+        /// Like the shared_ptr control blocks, resources dispatch through plain function pointers instead of
+        /// virtual functions, since avr-gcc keeps vtables in RAM. Every allocate/deallocate is one indirect call.
+        /// Resources abort if they can not satisfy a request, like running out of heap.
+        class memory_resource {
+        protected:
+            using allocate_fn = void* (*)(memory_resource*, size_t bytes, size_t alignment);
+            using deallocate_fn = void (*)(memory_resource*, void* p, size_t bytes, size_t alignment);
+            constexpr memory_resource(allocate_fn allocate, deallocate_fn deallocate)
+             : allocate_impl{allocate}, deallocate_impl{deallocate} {}
+            ~memory_resource() = default;
+        public:
+            static constexpr size_t default_alignment = __BIGGEST_ALIGNMENT__;
+            memory_resource(const memory_resource&) = delete;
+            auto operator=(const memory_resource&) -> memory_resource& = delete;
+
+            auto allocate(size_t bytes, size_t alignment = default_alignment) -> void* {
+                return allocate_impl(this, bytes, alignment);
+            }
+            /// bytes and alignment must be the same as when p was allocated
+            void deallocate(void* p, size_t bytes, size_t alignment = default_alignment) {
+                deallocate_impl(this, p, bytes, alignment);
+            }
+            /// Resources are only interchangeable with themselves
+            auto is_equal(const memory_resource& o) const -> bool { return this == &o; }
+
+        private:
+            allocate_fn allocate_impl;
+            deallocate_fn deallocate_impl;
+        };
+
+        inline auto operator==(const memory_resource& a, const memory_resource& b) -> bool { return a.is_equal(b); }
+        inline auto operator!=(const memory_resource& a, const memory_resource& b) -> bool { return !a.is_equal(b); }
+
+        class _new_delete_resource : public memory_resource {
+        public:
+            constexpr _new_delete_resource() : memory_resource{&do_allocate, &do_deallocate} {}
+        private:
+            static auto do_allocate(memory_resource*, size_t bytes, size_t) -> void* {
+                auto* p = ::operator new(bytes);
+                if(p == nullptr)
+                    abort();
+                return p;
+            }
+            static void do_deallocate(memory_resource*, void* p, size_t bytes, size_t) {
+                ::operator delete(p, bytes);
+            }
+        };
+
+        /// The global heap (operator new/delete). Constant initialized, so usable from static constructors
+        inline auto new_delete_resource() -> memory_resource* {
+            static _new_delete_resource instance{};
+            return &instance;
+        }
+
+        inline memory_resource* _default_resource = nullptr;
+        /// The resource default constructed polymorphic_allocators use. new_delete_resource() unless changed
+        inline auto get_default_resource() -> memory_resource* {
+            return _default_resource != nullptr ? _default_resource : new_delete_resource();
+        }
+        /// Returns the previous default. nullptr restores new_delete_resource()
+        inline auto set_default_resource(memory_resource* r) -> memory_resource* {
+            auto* previous = get_default_resource();
+            _default_resource = r;
+            return previous;
+        }
+
+        /// Header of a block the resources below got from their upstream resource. Padded to the strictest
+        /// alignment, so whatever follows it is suitably aligned too
+        struct alignas(__BIGGEST_ALIGNMENT__) _upstream_block {
+            _upstream_block* next;
+            size_t bytes;
+            auto data() -> unsigned char* { return reinterpret_cast<unsigned char*>(this + 1); }
+        };
+
+        inline auto _push_upstream_block(_upstream_block*& head, memory_resource* upstream, size_t bytes) -> _upstream_block* {
+            auto total = bytes + sizeof(_upstream_block);
+            auto* block = static_cast<_upstream_block*>(upstream->allocate(total, alignof(_upstream_block)));
+            block->next = head;
+            block->bytes = total;
+            head = block;
+            return block;
+        }
+
+        inline void _release_upstream_blocks(_upstream_block*& head, memory_resource* upstream) {
+            while(head != nullptr) {
+                auto* next = head->next;
+                upstream->deallocate(head, head->bytes, alignof(_upstream_block));
+                head = next;
+            }
+        }
+
+        /// Bump allocates from an initial buffer (if any), then from ever larger blocks requested from upstream.
+        /// deallocate does nothing, memory is only given back by release() or destruction.
+        /// Usage:
+        /// static unsigned char boot_scratch[128];
+        /// stl::pmr::monotonic_buffer_resource boot{boot_scratch, sizeof(boot_scratch)};
+        class monotonic_buffer_resource : public memory_resource {
+        public:
+            explicit monotonic_buffer_resource(memory_resource* upstream = get_default_resource())
+             : monotonic_buffer_resource{nullptr, 0, upstream} {}
+            explicit monotonic_buffer_resource(size_t initial_size, memory_resource* upstream = get_default_resource())
+             : monotonic_buffer_resource{nullptr, 0, upstream} { next_size = initial_size == 0 ? 1 : initial_size; }
+            monotonic_buffer_resource(void* buffer, size_t size, memory_resource* upstream = get_default_resource())
+             : memory_resource{&do_allocate, &do_deallocate}, upstream{upstream}, blocks{nullptr},
+               initial{static_cast<unsigned char*>(buffer)}, initial_size{size}, current{initial}, space{size},
+               next_size{size > AVRCPP_DEFAULT_MONOTONIC_BLOCK_SIZE / 2 ? size * 2 : AVRCPP_DEFAULT_MONOTONIC_BLOCK_SIZE} {}
+            ~monotonic_buffer_resource() { release(); }
+
+            /// Give all upstream blocks back and start over at the beginning of the initial buffer
+            void release() {
+                _release_upstream_blocks(blocks, upstream);
+                current = initial;
+                space = initial_size;
+            }
+            auto upstream_resource() const -> memory_resource* { return upstream; }
+
+        private:
+            static auto do_allocate(memory_resource* r, size_t bytes, size_t alignment) -> void* {
+                auto* self = static_cast<monotonic_buffer_resource*>(r);
+                if(auto* p = self->bump(bytes, alignment))
+                    return p;
+                // Ask for a block large enough for this request even in the worst alignment case
+                auto size = self->next_size;
+                while(size < bytes + alignment)
+                    size *= 2;
+                self->next_size = size * 2;
+                self->current = _push_upstream_block(self->blocks, self->upstream, size)->data();
+                self->space = size;
+                return self->bump(bytes, alignment);
+            }
+            static void do_deallocate(memory_resource*, void*, size_t, size_t) {}
+
+            auto bump(size_t bytes, size_t alignment) -> void* {
+                auto padding = static_cast<size_t>((~reinterpret_cast<uintptr_t>(current) + 1) & (alignment - 1));
+                if(current == nullptr || padding + bytes > space)
+                    return nullptr;
+                auto* p = current + padding;
+                current = p + bytes;
+                space -= padding + bytes;
+                return p;
+            }
+
+            memory_resource* upstream;
+            _upstream_block* blocks;
+            unsigned char* initial;
+            size_t initial_size;
+            unsigned char* current;
+            size_t space;
+            size_t next_size;
+        };
+
+        struct pool_options {
+            /// Upper bound for how many blocks a pool asks upstream for at once. Chunks start at one block and double
+            size_t max_blocks_per_chunk = 16;
+            /// Requests larger than this go straight to upstream
+            size_t largest_required_pool_block = 64;
+        };
+
+        /// Power-of-two size classes, each with an intrusive free list, refilled with chunks from upstream.
+        /// Freed blocks are reused right away and there is no per-block header. Not safe to use from
+        /// several threads or ISRs at once. All memory goes back to upstream on release() or destruction.
+        class unsynchronized_pool_resource : public memory_resource {
+            static constexpr size_t smallest_block = sizeof(void*); // a free block holds the free-list link
+            static constexpr uint8_t max_pools = 8;
+            struct free_block { free_block* next; };
+            struct pool {
+                free_block* free;
+                size_t next_chunk_blocks;
+            };
+        public:
+            explicit unsynchronized_pool_resource(memory_resource* upstream = get_default_resource())
+             : unsynchronized_pool_resource{pool_options{}, upstream} {}
+            explicit unsynchronized_pool_resource(const pool_options& options, memory_resource* upstream = get_default_resource())
+             : memory_resource{&do_allocate, &do_deallocate}, upstream{upstream}, chunks{nullptr},
+               max_blocks_per_chunk{options.max_blocks_per_chunk == 0 ? 1 : options.max_blocks_per_chunk}, pool_count{1}, pools{} {
+                while(pool_count < max_pools && block_size(pool_count - 1) < options.largest_required_pool_block)
+                    pool_count++;
+                release();
+            }
+            ~unsynchronized_pool_resource() { release(); }
+
+            void release() {
+                _release_upstream_blocks(chunks, upstream);
+                for(auto& p : pools)
+                    p = pool{nullptr, 1};
+            }
+            auto upstream_resource() const -> memory_resource* { return upstream; }
+            auto largest_pool_block() const -> size_t { return block_size(pool_count - 1); }
+
+        private:
+            static constexpr auto block_size(uint8_t index) -> size_t { return smallest_block << index; }
+            /// Smallest pool whose blocks hold `bytes` with the given alignment, or pool_count if none does
+            auto pool_index(size_t bytes, size_t alignment) const -> uint8_t {
+                if(alignment > __BIGGEST_ALIGNMENT__)
+                    return pool_count;
+                bytes = bytes < alignment ? alignment : bytes; // power-of-two blocks are aligned to their size
+                uint8_t i = 0;
+                while(i < pool_count && block_size(i) < bytes)
+                    i++;
+                return i;
+            }
+            static auto do_allocate(memory_resource* r, size_t bytes, size_t alignment) -> void* {
+                auto* self = static_cast<unsynchronized_pool_resource*>(r);
+                auto index = self->pool_index(bytes, alignment);
+                if(index == self->pool_count)
+                    return self->upstream->allocate(bytes, alignment);
+                auto& p = self->pools[index];
+                if(p.free == nullptr)
+                    self->refill(index);
+                auto* block = p.free;
+                p.free = block->next;
+                return block;
+            }
+            static void do_deallocate(memory_resource* r, void* ptr, size_t bytes, size_t alignment) {
+                auto* self = static_cast<unsynchronized_pool_resource*>(r);
+                auto index = self->pool_index(bytes, alignment);
+                if(index == self->pool_count) {
+                    self->upstream->deallocate(ptr, bytes, alignment);
+                    return;
+                }
+                auto* block = static_cast<free_block*>(ptr);
+                block->next = self->pools[index].free;
+                self->pools[index].free = block;
+            }
+            void refill(uint8_t index) {
+                auto& p = pools[index];
+                auto size = block_size(index);
+                auto* data = _push_upstream_block(chunks, upstream, p.next_chunk_blocks * size)->data();
+                for(auto i = p.next_chunk_blocks; i-- > 0;) {
+                    auto* block = reinterpret_cast<free_block*>(data + i * size);
+                    block->next = p.free;
+                    p.free = block;
+                }
+                p.next_chunk_blocks = p.next_chunk_blocks * 2 <= max_blocks_per_chunk ? p.next_chunk_blocks * 2 : max_blocks_per_chunk;
+            }
+
+            memory_resource* upstream;
+            _upstream_block* chunks;
+            size_t max_blocks_per_chunk;
+            uint8_t pool_count;
+            pool pools[max_pools];
+        };
+
+        /// Allocator handle over a memory_resource. Default constructed, it uses get_default_resource().
+        /// Copies (also to other value types) allocate from the same resource.
+        /// Usage:
+        /// stl::pmr::unsynchronized_pool_resource task_pool{};
+        /// stl::pmr::vector<int> samples{&task_pool};
+        template<typename T>
+        class polymorphic_allocator {
+        public:
+            using value_type = T;
+
+            polymorphic_allocator() : source{get_default_resource()} {}
+            polymorphic_allocator(memory_resource* resource) : source{resource} {}
+            template<typename U>
+            polymorphic_allocator(const polymorphic_allocator<U>& o) : source{o.resource()} {}
+
+            auto allocate(size_t n) -> T* { return static_cast<T*>(source->allocate(n * sizeof(T), alignof(T))); }
+            void deallocate(T* p, size_t n) { source->deallocate(p, n * sizeof(T), alignof(T)); }
+            auto resource() const -> memory_resource* { return source; }
+
+            template<typename U>
+            auto operator==(const polymorphic_allocator<U>& o) const -> bool { return *source == *o.resource(); }
+            template<typename U>
+            auto operator!=(const polymorphic_allocator<U>& o) const -> bool { return !(*this == o); }
+
+        private:
+            memory_resource* source;
+        };
+    }
+}
+
+#endif
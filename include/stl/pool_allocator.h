@@ -0,0 +1,178 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_POOL_ALLOCATOR_H
+#define AVRCPP_POOL_ALLOCATOR_H
+#include "default_includes"
+#include "type_traits.h"
+
+namespace stl {
+    /// BlockCount blocks of BlockSize bytes in a statically reserved arena, allocated and freed in O(1).
+    /// Free blocks hold the index of the next free block in their first bytes, and blocks that have never been
+    /// handed out are tracked by a watermark, so there is no per-block header and no initialization loop.
+    /// Constant initialized to all zeros, so a global pool lands in .bss and is ready before any static constructor runs.
+    template<size_t BlockSize, size_t BlockCount>
+    class fixed_block_pool {
+    public:
+        using index_type = stl::smallest_uint_t<BlockCount>;
+        static constexpr size_t block_size = BlockSize;
+        static constexpr size_t block_count = BlockCount;
+        static_assert(BlockCount > 0, "a pool needs at least one block");
+        static_assert(BlockSize >= sizeof(index_type), "blocks must be able to hold a free-list index");
+        // Largest power of two dividing the block size, capped at the strictest alignment of the target
+        static constexpr size_t alignment = (BlockSize & (~BlockSize + 1)) < __BIGGEST_ALIGNMENT__ ?
+                                            (BlockSize & (~BlockSize + 1)) : __BIGGEST_ALIGNMENT__;
+
+        constexpr fixed_block_pool() : storage{}, free_head{0}, watermark{0}, used{0} {}
+        fixed_block_pool(const fixed_block_pool&) = delete;
+        auto operator=(const fixed_block_pool&) -> fixed_block_pool& = delete;
+
+        /// A free block, or nullptr if the pool is exhausted
+        auto allocate() -> void* {
+            index_type index;
+            if(free_head != 0) {
+                index = static_cast<index_type>(free_head - 1);
+                memcpy(&free_head, block(index), sizeof(index_type));
+            } else if(watermark != BlockCount) {
+                index = watermark++;
+            } else {
+                return nullptr;
+            }
+            used++;
+            return block(index);
+        }
+        /// A free block if `bytes` fits in one, otherwise nullptr
+        auto allocate(size_t bytes) -> void* {
+            return bytes <= BlockSize ? allocate() : nullptr;
+        }
+
+        /// p must have been handed out by this pool (see owns())
+        void deallocate(void* p) {
+            auto index = static_cast<index_type>((static_cast<unsigned char*>(p) - storage) / BlockSize);
+            memcpy(p, &free_head, sizeof(index_type));
+            free_head = static_cast<index_type>(index + 1);
+            used--;
+        }
+
+        auto owns(const void* p) const -> bool {
+            auto* c = static_cast<const unsigned char*>(p);
+            return c >= storage && c < storage + sizeof(storage);
+        }
+        auto in_use() const -> index_type { return used; }
+        auto available() const -> index_type { return static_cast<index_type>(BlockCount - used); }
+
+    private:
+        auto block(index_type index) -> unsigned char* { return storage + static_cast<size_t>(index) * BlockSize; }
+
+        alignas(alignment) unsigned char storage[BlockSize * BlockCount];
+        index_type free_head; // one past the first free block, so that 0 (the zero state) means "none"
+        index_type watermark;
+        index_type used;
+    };
+
+    template<typename... Pools>
+    struct _pool_chain {
+        constexpr _pool_chain() = default;
+        auto allocate(size_t) -> void* { return nullptr; }
+        auto deallocate(void*) -> bool { return false; }
+    };
+
+    template<typename Pool, typename... Rest>
+    struct _pool_chain<Pool, Rest...> {
+        Pool pool;
+        _pool_chain<Rest...> rest;
+
+        constexpr _pool_chain() = default;
+        auto allocate(size_t n) -> void* {
+            if(n <= Pool::block_size) {
+                if(auto* p = pool.allocate())
+                    return p;
+            }
+            return rest.allocate(n); // exhausted classes spill into the next larger one
+        }
+        auto deallocate(void* p) -> bool {
+            if(!pool.owns(p))
+                return rest.deallocate(p);
+            pool.deallocate(p);
+            return true;
+        }
+    };
+
+    /// Size-class allocator. Requests are served by the smallest pool whose blocks fit (Pools must be
+    /// ordered by ascending block size) and fall back to malloc when no pool can take them.
+    /// Usage:
+    /// stl::size_class_allocator<stl::fixed_block_pool<8, 32>, stl::fixed_block_pool<32, 8>> small_objects{};
+    /// auto* p = small_objects.allocate(6); // one of the 8 byte blocks
+    template<typename... Pools>
+    class size_class_allocator {
+    public:
+        constexpr size_class_allocator() : pools{}, fallbacks{0} {}
+        size_class_allocator(const size_class_allocator&) = delete;
+        auto operator=(const size_class_allocator&) -> size_class_allocator& = delete;
+
+        auto allocate(size_t n) -> void* {
+            if(auto* p = pools.allocate(n))
+                return p;
+            fallbacks++;
+            return malloc(n);
+        }
+        void deallocate(void* p) {
+            if(p != nullptr && !pools.deallocate(p))
+                free(p);
+        }
+        /// Amount of requests that had to go to malloc. A good hint for tuning the pool sizes
+        auto fallback_count() const -> size_t { return fallbacks; }
+
+    private:
+        _pool_chain<Pools...> pools;
+        size_t fallbacks;
+    };
+
+    /// Typed allocator handle over a pool (a fixed_block_pool or a size_class_allocator), so containers
+    /// and smart pointers can draw from it. Requests the pool can not serve abort, like running out of heap.
+    /// Usage:
+    /// static stl::fixed_block_pool<sizeof(job), 8> job_pool{};
+    /// auto j = stl::allocate_unique<job>(stl::pool_allocator<job, decltype(job_pool)>{job_pool});
+    template<typename T, typename Pool>
+    class pool_allocator {
+    public:
+        using value_type = T;
+
+        explicit pool_allocator(Pool& pool) : source{&pool} {}
+        template<typename U>
+        pool_allocator(const pool_allocator<U, Pool>& o) : source{&o.resource()} {}
+
+        auto allocate(size_t n) -> T* {
+            auto* p = source->allocate(n * sizeof(T));
+            if(p == nullptr)
+                abort();
+            return static_cast<T*>(p);
+        }
+        void deallocate(T* p, size_t) { source->deallocate(p); }
+        auto resource() const -> Pool& { return *source; }
+
+        template<typename U>
+        auto operator==(const pool_allocator<U, Pool>& o) const -> bool { return source == &o.resource(); }
+        template<typename U>
+        auto operator!=(const pool_allocator<U, Pool>& o) const -> bool { return !(*this == o); }
+
+    private:
+        Pool* source;
+    };
+}
+
+#endif
@@ -0,0 +1,125 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_REF_COUNT_H
+#define AVRCPP_REF_COUNT_H
+#include "default_includes"
+#include "atomic.h"
+
+namespace stl {
+    //// Reference count policies for shared_ptr/weak_ptr. A policy selects the counter type
+    //// and how it is modified. Every policy provides:
+    ////   counter_type
+    ////   increment(c)            - add a reference
+    ////   decrement(c)            - drop a reference, returns true when it was the last one
+    ////   increment_if_nonzero(c) - add a reference unless the count already reached zero (weak_ptr::lock)
+    ////   load(c)
+    //// With AVRCPP_DEBUG defined, increments abort instead of silently wrapping the counter to zero.
+    namespace ref_count {
+        template<typename CounterT>
+        inline void check_overflow(CounterT c) {
+#ifdef AVRCPP_DEBUG
+            if(c == static_cast<CounterT>(~CounterT{0}))
+                abort();
+#else
+            (void)c;
+#endif
+        }
+
+        /// No synchronization at all. Only use it when all copies live in the same context (no ISRs touch them)
+        template<typename CounterT = uint8_t>
+        struct plain {
+            using counter_type = CounterT;
+            static void increment(counter_type& c) {
+                check_overflow(c);
+                ++c;
+            }
+            static auto decrement(counter_type& c) -> bool {
+                return --c == 0;
+            }
+            static auto increment_if_nonzero(counter_type& c) -> bool {
+                if(c == 0)
+                    return false;
+                increment(c);
+                return true;
+            }
+            static auto load(const counter_type& c) -> counter_type {
+                return c;
+            }
+        };
+
+        /// Every counter access runs with interrupts disabled, so copies can be made and dropped from ISRs.
+        /// Needed for anything wider than a byte on AVR, but even byte increments are read-modify-write sequences there.
+        template<typename CounterT = uint8_t>
+        struct interrupt_masked {
+            using counter_type = CounterT;
+            static void increment(counter_type& c) {
+                interrupt_guard guard{};
+                plain<CounterT>::increment(c);
+            }
+            static auto decrement(counter_type& c) -> bool {
+                interrupt_guard guard{};
+                return --c == 0;
+            }
+            static auto increment_if_nonzero(counter_type& c) -> bool {
+                interrupt_guard guard{};
+                return plain<CounterT>::increment_if_nonzero(c);
+            }
+            static auto load(const counter_type& c) -> counter_type {
+                interrupt_guard guard{};
+                return c;
+            }
+        };
+
+#ifndef __AVR__
+        /// Atomic read-modify-write operations for sharing pointers between threads on hosted builds.
+        /// Uses the same __atomic builtins std::atomic is built on, avr-libc has no library support for them.
+        template<typename CounterT = uint32_t>
+        struct atomic {
+            using counter_type = CounterT;
+            static void increment(counter_type& c) {
+                check_overflow(__atomic_fetch_add(&c, 1, __ATOMIC_RELAXED));
+            }
+            static auto decrement(counter_type& c) -> bool {
+                // acq_rel: the last owner must see every write other owners made before they let go
+                return __atomic_sub_fetch(&c, 1, __ATOMIC_ACQ_REL) == 0;
+            }
+            static auto increment_if_nonzero(counter_type& c) -> bool {
+                auto expected = __atomic_load_n(&c, __ATOMIC_RELAXED);
+                do {
+                    if(expected == 0)
+                        return false;
+                    check_overflow(expected);
+                } while(!__atomic_compare_exchange_n(&c, &expected, static_cast<counter_type>(expected + 1), true,
+                                                     __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+                return true;
+            }
+            static auto load(const counter_type& c) -> counter_type {
+                return __atomic_load_n(&c, __ATOMIC_ACQUIRE);
+            }
+        };
+#endif
+    }
+
+#ifdef AVRCPP_DEFAULT_REF_COUNT_POLICY
+    using default_ref_count_policy = AVRCPP_DEFAULT_REF_COUNT_POLICY;
+#else
+    using default_ref_count_policy = ref_count::plain<uint8_t>;
+#endif
+}
+
+#endif
@@ -0,0 +1,385 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_RING_BUFFER_H
+#define AVRCPP_RING_BUFFER_H
+#include "default_includes"
+#include "algorithm.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+#include "../utility"
+
+namespace stl {
+    //// What a ring_buffer does when pushing into a full buffer
+    namespace ring_policy {
+        /// Refuse the new element, the push returns false
+        struct reject { static constexpr bool overwrites = false; };
+        /// Drop the element at the opposite end (the oldest one, when used as a FIFO) to make room
+        struct overwrite { static constexpr bool overwrites = true; };
+    }
+
+    /// Index that is stored as an enum instead of a plain (usually character typed) integer. Character typed
+    /// objects may alias any element the buffer stores, so the compiler would reload and rewrite them after
+    /// every push and pop. The enum has an alias set of its own, letting head and count stay in registers
+    /// (element stores of a character typed T still alias everything, so byte buffers don't benefit)
+    template<typename I>
+    struct _ring_index {
+        enum class stored : I {};
+        stored value;
+        constexpr _ring_index(I i = 0) : value{static_cast<stored>(i)} {}
+        constexpr operator I() const { return static_cast<I>(value); }
+        auto operator++(int) -> I { auto old = I(*this); *this = static_cast<I>(old + 1); return old; }
+        auto operator--(int) -> I { auto old = I(*this); *this = static_cast<I>(old - 1); return old; }
+    };
+
+    /// Fixed-capacity double ended ring buffer. Never allocates, so it is suitable for ISR-fed
+    /// sample queues. When N is a power of two, index wrapping is a single mask.
+    /// Bulk push_n/pop_n copy contiguous spans in at most two segments (memcpy for trivially copyable T).
+    /// Usage:
+    /// stl::ring_buffer<uint8_t, 64> uart_rx;
+    /// stl::ring_buffer<sample, 16, stl::ring_policy::overwrite> latest_samples;
+    template<typename T, size_t N, typename FullPolicy = ring_policy::reject>
+    class ring_buffer {
+        static_assert(N > 0, "ring_buffer needs room for at least one element");
+        static constexpr bool is_power_of_two = (N & (N - 1)) == 0;
+    public:
+        using value_type = T;
+        using reference = T&;
+        using const_reference = const T&;
+        using size_type = stl::smallest_uint_t<N>;
+
+        struct iterator {
+            ring_buffer* ring;
+            size_type index;
+            auto operator*() const -> reference { return (*ring)[index]; }
+            auto operator->() const -> T* { return &(*ring)[index]; }
+            auto operator++() -> iterator& { ++index; return *this; }
+            auto operator--() -> iterator& { --index; return *this; }
+            auto operator+(ptrdiff_t n) const -> iterator { return {ring, static_cast<size_type>(index + n)}; }
+            auto operator-(ptrdiff_t n) const -> iterator { return {ring, static_cast<size_type>(index - n)}; }
+            auto operator-(const iterator& o) const -> ptrdiff_t { return static_cast<ptrdiff_t>(index) - o.index; }
+            auto operator[](ptrdiff_t n) const -> reference { return (*ring)[static_cast<size_type>(index + n)]; }
+            auto operator==(const iterator& o) const -> bool { return index == o.index && ring == o.ring; }
+            auto operator!=(const iterator& o) const -> bool { return !(*this == o); }
+        };
+
+        ring_buffer();
+        ring_buffer(const ring_buffer& o);
+        ~ring_buffer();
+        auto operator=(const ring_buffer& o) -> ring_buffer&;
+
+        static constexpr auto capacity() -> size_type { return N; }
+        auto size() const -> size_type;
+        auto empty() const -> bool;
+        auto full() const -> bool;
+        auto begin() -> iterator;
+        auto end() -> iterator;
+        auto front() -> reference;
+        auto front() const -> const_reference;
+        auto back() -> reference;
+        auto back() const -> const_reference;
+        auto operator[](size_type index) -> reference;
+        auto operator[](size_type index) const -> const_reference;
+        /// Bounds checked element access. Aborts if index is out of range
+        auto at(size_type index) -> reference;
+
+        /// Push functions return false if the element was rejected (only possible with ring_policy::reject)
+        auto push_back(const_reference v) -> bool;
+        auto push_back(value_type&& v) -> bool;
+        template<typename... Args>
+        auto emplace_back(Args&&... args) -> bool;
+        auto push_front(const_reference v) -> bool;
+        auto push_front(value_type&& v) -> bool;
+        template<typename... Args>
+        auto emplace_front(Args&&... args) -> bool;
+        /// Pop functions return false if the buffer was empty
+        auto pop_front() -> bool;
+        auto pop_back() -> bool;
+        void clear();
+
+        /// Append up to n elements from src. Returns the amount of elements that were stored.
+        /// With ring_policy::overwrite all n are accepted, but only the newest N survive.
+        auto push_n(const T* src, size_t n) -> size_t;
+        /// Move up to n elements from the front into dst. Returns the amount of elements popped
+        auto pop_n(T* dst, size_t n) -> size_t;
+
+    private:
+        static constexpr auto wrap(size_t i) -> size_type;
+        auto data() -> T*;
+        auto data() const -> const T*;
+        auto slot(size_type index) -> T*;
+        auto slot(size_type index) const -> const T*;
+
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+        _ring_index<size_type> head;
+        _ring_index<size_type> count;
+    };
+
+    template<typename T, size_t N, typename P>
+    ring_buffer<T,N,P>::ring_buffer() : head{0}, count{0} { }
+
+    template<typename T, size_t N, typename P>
+    ring_buffer<T,N,P>::ring_buffer(const ring_buffer& o) : head{0}, count{0} {
+        for(size_type i = 0; i < o.count; i++)
+            push_back(o[i]);
+    }
+
+    template<typename T, size_t N, typename P>
+    ring_buffer<T,N,P>::~ring_buffer() {
+        clear();
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::operator=(const ring_buffer& o) -> ring_buffer& {
+        if(this == &o)
+            return *this;
+        clear();
+        for(size_type i = 0; i < o.count; i++)
+            push_back(o[i]);
+        return *this;
+    }
+
+    template<typename T, size_t N, typename P>
+    constexpr auto ring_buffer<T,N,P>::wrap(size_t i) -> size_type {
+        if constexpr(is_power_of_two)
+            return static_cast<size_type>(i & (N - 1));
+        else
+            return static_cast<size_type>(i >= N ? i - N : i); // i is always < 2N
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::data() -> T* {
+        return reinterpret_cast<T*>(buffer);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::data() const -> const T* {
+        return reinterpret_cast<const T*>(buffer);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::slot(size_type index) -> T* {
+        return data() + wrap(static_cast<size_t>(head) + index);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::slot(size_type index) const -> const T* {
+        return data() + wrap(static_cast<size_t>(head) + index);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::size() const -> size_type {
+        return count;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::empty() const -> bool {
+        return count == 0;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::full() const -> bool {
+        return count == N;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::begin() -> iterator {
+        return {this, 0};
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::end() -> iterator {
+        return {this, count};
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::front() -> reference {
+        return *slot(0);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::front() const -> const_reference {
+        return *slot(0);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::back() -> reference {
+        return *slot(count - 1);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::back() const -> const_reference {
+        return *slot(count - 1);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::operator[](size_type index) -> reference {
+        return *slot(index);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::operator[](size_type index) const -> const_reference {
+        return *slot(index);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::at(size_type index) -> reference {
+        if(index >= count)
+            abort();
+        return *slot(index);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::push_back(const_reference v) -> bool {
+        return emplace_back(v);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::push_back(value_type&& v) -> bool {
+        return emplace_back(stl::move(v));
+    }
+
+    template<typename T, size_t N, typename P>
+    template<typename... Args>
+    auto ring_buffer<T,N,P>::emplace_back(Args&&... args) -> bool {
+        if(full()) {
+            if constexpr(!P::overwrites)
+                return false;
+            else {
+                // The arguments may refer to the element being evicted, so build the new one first
+                T v(stl::forward<Args>(args)...);
+                pop_front();
+                new(slot(count)) T(stl::move(v));
+                count++;
+                return true;
+            }
+        }
+        new(slot(count)) T(stl::forward<Args>(args)...);
+        count++;
+        return true;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::push_front(const_reference v) -> bool {
+        return emplace_front(v);
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::push_front(value_type&& v) -> bool {
+        return emplace_front(stl::move(v));
+    }
+
+    template<typename T, size_t N, typename P>
+    template<typename... Args>
+    auto ring_buffer<T,N,P>::emplace_front(Args&&... args) -> bool {
+        if(full()) {
+            if constexpr(!P::overwrites)
+                return false;
+            else {
+                // The arguments may refer to the element being evicted, so build the new one first
+                T v(stl::forward<Args>(args)...);
+                pop_back();
+                head = wrap(static_cast<size_t>(head) + N - 1);
+                new(data() + head) T(stl::move(v));
+                count++;
+                return true;
+            }
+        }
+        head = wrap(static_cast<size_t>(head) + N - 1);
+        new(data() + head) T(stl::forward<Args>(args)...);
+        count++;
+        return true;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::pop_front() -> bool {
+        if(empty())
+            return false;
+        if constexpr(!stl::is_trivially_destructible<T>::value)
+            slot(0)->~T();
+        head = wrap(static_cast<size_t>(head) + 1);
+        count--;
+        return true;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::pop_back() -> bool {
+        if(empty())
+            return false;
+        if constexpr(!stl::is_trivially_destructible<T>::value)
+            slot(count - 1)->~T();
+        count--;
+        return true;
+    }
+
+    template<typename T, size_t N, typename P>
+    void ring_buffer<T,N,P>::clear() {
+        if constexpr(!stl::is_trivially_destructible<T>::value) {
+            for(size_type i = 0; i < count; i++)
+                slot(i)->~T();
+        }
+        head = 0;
+        count = 0;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::push_n(const T* src, size_t n) -> size_t {
+        auto accepted = n;
+        if constexpr(P::overwrites) {
+            if(n > N) { // only the newest N can survive anyway
+                src += n - N;
+                n = N;
+            }
+            auto free_slots = static_cast<size_t>(N - count);
+            for(size_t i = free_slots; i < n; i++)
+                pop_front();
+        } else {
+            if(n > static_cast<size_t>(N - count))
+                n = N - count;
+            accepted = n;
+        }
+        // At most two contiguous segments: up to the end of the buffer, then from the start
+        auto tail = wrap(static_cast<size_t>(head) + count);
+        auto first_segment = stl::min(n, static_cast<size_t>(N - tail));
+        uninitialized_copy_n(src, first_segment, data() + tail);
+        uninitialized_copy_n(src + first_segment, n - first_segment, data());
+        count = static_cast<size_type>(count + n);
+        return accepted;
+    }
+
+    template<typename T, size_t N, typename P>
+    auto ring_buffer<T,N,P>::pop_n(T* dst, size_t n) -> size_t {
+        if(n > count)
+            n = count;
+        auto first_segment = stl::min(n, static_cast<size_t>(N - head));
+        // dst is assumed to hold live objects, so this is an assignment rather than a construction
+        if constexpr(stl::is_trivially_copyable<T>::value) {
+            memcpy((void*)dst, (const void*)(data() + head), first_segment * sizeof(T));
+            memcpy((void*)(dst + first_segment), (const void*)data(), (n - first_segment) * sizeof(T));
+        } else {
+            for(size_t i = 0; i < n; i++)
+                dst[i] = stl::move(*slot(static_cast<size_type>(i)));
+            destroy_n(data() + head, first_segment);
+            destroy_n(data(), n - first_segment);
+        }
+        head = wrap(static_cast<size_t>(head) + n);
+        count = static_cast<size_type>(count - n);
+        return n;
+    }
+}
+
+#endif //AVRCPP_RING_BUFFER_H
@@ -11,17 +11,111 @@
  *
  *  You should have received a copy of the GNU General Public License
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
- * 
- * 
+ *
+ *
  * original author: sillydan1 <https://github.com/sillydan1>
  * */
 #ifndef SHARED_PTR_HPP
 #define SHARED_PTR_HPP
+#include "allocator.h"
 #include "default_deleters.h"
 #include "default_includes"
+#include "ref_count.h"
+#include "uninitialized.h"
+#include "../utility"
 
 namespace stl {
-    template <typename T, typename D = default_deleter<T>>
+    //// Control blocks. Every owned object is tracked by exactly one block holding the reference counts
+    //// and a function that tears the object and the block down again. A plain function pointer is
+    //// used instead of virtual functions, since avr-gcc keeps vtables in RAM.
+    //// The object is disposed when the strong count drops to zero, the block itself is freed when the
+    //// weak count drops to zero. All strong references together hold one weak reference, so a block
+    //// without weak_ptrs is freed right after its object.
+    //// The counter type and how it is modified is decided by the Policy (see ref_count.h).
+    template<typename Policy>
+    struct _shared_control_block {
+        using counter_type = typename Policy::counter_type;
+        enum class action : uint8_t { dispose, deallocate };
+        using manage_fn = void(*)(_shared_control_block*, action);
+        manage_fn manage;
+        counter_type strong;
+        counter_type weak;
+
+        explicit _shared_control_block(manage_fn manage) : manage{manage}, strong{1}, weak{1} { }
+        void add_strong() { Policy::increment(strong); }
+        auto try_add_strong() -> bool { return Policy::increment_if_nonzero(strong); }
+        void add_weak() { Policy::increment(weak); }
+        auto use_count() const -> counter_type { return Policy::load(strong); }
+        void release_strong() {
+            if(!Policy::decrement(strong))
+                return;
+            manage(this, action::dispose);
+            release_weak();
+        }
+        void release_weak() {
+            if(Policy::decrement(weak))
+                manage(this, action::deallocate);
+        }
+    };
+
+    /// Control block for adopted raw pointers. The object lives in its own allocation
+    /// and is released with the deleter D
+    template<typename T_t, typename D, typename Policy>
+    struct _shared_pointer_block : _shared_control_block<Policy> {
+        using base = _shared_control_block<Policy>;
+        using action = typename base::action;
+        T_t* resource;
+
+        explicit _shared_pointer_block(T_t* resource) : base{&manage_self}, resource{resource} { }
+        static void manage_self(base* block, action what) {
+            auto* self = static_cast<_shared_pointer_block*>(block);
+            if(what == action::dispose)
+                D{}.free(self->resource); // Custom deleter instantiation
+            else
+                delete self;
+        }
+    };
+
+    /// Control block with N objects stored right behind the counters, so make_shared, allocate_shared
+    /// and make_shared_array only need a single allocation. The block is allocated from Alloc (rebound to
+    /// the block type) and keeps a copy of it to free itself again. Stateless allocators take up no space.
+    /// Note that weak_ptrs keep the whole block (including the dead objects' storage) allocated.
+    template<typename T_t, size_t N, typename Policy, typename Alloc = stl::allocator<T_t>>
+    struct _shared_inplace_block : _shared_control_block<Policy>, private _allocator_holder<Alloc> {
+        using base = _shared_control_block<Policy>;
+        using action = typename base::action;
+        using block_allocator = allocator_rebind_t<Alloc, _shared_inplace_block>;
+        alignas(T_t) unsigned char storage[N * sizeof(T_t)];
+
+        explicit _shared_inplace_block(const Alloc& allocator) : base{&manage_self}, _allocator_holder<Alloc>{allocator} { }
+        auto get() -> T_t* { return reinterpret_cast<T_t*>(storage); }
+        static auto create(const Alloc& allocator) -> _shared_inplace_block* {
+            block_allocator a{allocator};
+            return new(a.allocate(1)) _shared_inplace_block(allocator);
+        }
+        static void manage_self(base* block, action what) {
+            auto* self = static_cast<_shared_inplace_block*>(block);
+            if(what == action::dispose) {
+                destroy_n(self->get(), N);
+                return;
+            }
+            block_allocator a{self->alloc()};
+            self->~_shared_inplace_block();
+            a.deallocate(self, 1);
+        }
+    };
+
+    template<typename T, typename Policy> class weak_ptr;
+
+    /// Shared pointer class. Reference counted pointer with shared ownership of the resource.
+    /// Prefer make_shared/make_shared_array, they allocate the object together with its control block.
+    /// Adopting a raw pointer allocates a separate control block and releases the pointer with D.
+    /// Policy picks the counter width and whether counting is safe against ISRs or threads (see ref_count.h).
+    /// Usage:
+    /// auto a = stl::make_shared<int>(42);   // one allocation
+    /// stl::shared_ptr<int> b{new int(42)};  // two allocations
+    /// auto c = stl::make_shared<int, stl::ref_count::interrupt_masked<uint16_t>>(42);
+    template <typename T, typename D = default_deleter<T>, typename Policy = default_ref_count_policy>
     class shared_ptr {
         using T_t = stl::remove_array_t<T>;
         template<typename R>
@@ -30,25 +124,44 @@ namespace stl {
                 stl::is_base_of<T_t,stl::remove_array_t<R>>,
                 stl::is_same<stl::remove_array_t<T>,stl::remove_array_t<R>>
         >;
+        using control_block = _shared_control_block<Policy>;
+        template<typename, typename, typename> friend class shared_ptr;
+        template<typename, typename> friend class weak_ptr;
     public:
+        using counter_type = typename Policy::counter_type;
+
         shared_ptr()
-                : resource(nullptr), refCount(new uint8_t(1)) {}
+                : resource(nullptr), control(nullptr) {}
         shared_ptr(T_t* a)
-                : resource(a), refCount(new uint8_t(1))
+                : resource(a), control(a ? new _shared_pointer_block<T_t, D, Policy>(a) : nullptr)
         { }
-        template<typename R>
-        shared_ptr(const shared_ptr<R>& ptr2)
-                : resource(static_cast<T_t*>(ptr2.get())), refCount(ptr2.get_counter())
+        template<typename R, typename E>
+        shared_ptr(const shared_ptr<R, E, Policy>& ptr2)
+                : resource(static_cast<T_t*>(ptr2.resource)), control(ptr2.control)
         {
             static_assert(is_derived<R>::value, "Can only copy pointers of derived classes!");
-            ++*refCount;
+            acquire();
+        }
+        shared_ptr(const shared_ptr& ptr2)
+                : resource(ptr2.resource), control(ptr2.control)
+        { acquire(); }
+        /// Moves steal the reference of ptr2, the counter is not touched
+        shared_ptr(shared_ptr&& ptr2) noexcept
+                : resource(ptr2.resource), control(ptr2.control)
+        {
+            ptr2.resource = nullptr;
+            ptr2.control = nullptr;
+        }
+        template<typename R, typename E>
+        shared_ptr(shared_ptr<R, E, Policy>&& ptr2) noexcept
+                : resource(static_cast<T_t*>(ptr2.resource)), control(ptr2.control)
+        {
+            static_assert(is_derived<R>::value, "Can only move pointers of derived classes!");
+            ptr2.resource = nullptr;
+            ptr2.control = nullptr;
         }
-        shared_ptr(const shared_ptr<T>& ptr2)
-                : resource(ptr2.resource), refCount(ptr2.refCount)
-        { ++*refCount; }
         ~shared_ptr() {
-            if (refCount != NULL && --*refCount == 0)
-                freeResource();
+            release();
         }
 
         inline T_t* operator->() const {
@@ -67,62 +180,196 @@ namespace stl {
             return resource[i];
         }
         inline T_t* get() const { return resource; }
-        inline uint8_t* get_counter() const { return refCount; }
-        inline uint8_t use_count() const {
-            if(refCount == nullptr)
+        inline counter_type use_count() const {
+            if(control == nullptr)
                 return 0;
-            return *refCount;
+            return control->use_count();
         }
-        template <typename R>
-        shared_ptr& operator=(const shared_ptr<R>& ptr2) noexcept {
+        template <typename R, typename E>
+        shared_ptr& operator=(const shared_ptr<R, E, Policy>& ptr2) noexcept {
             static_assert(is_derived<R>::value, "Can only copy pointers of derived classes!");
-            if(--*refCount == 0)
-                freeResource();
-            resource = static_cast<T_t*>(ptr2.get());
-            refCount = ptr2.get_counter();
-            ++*refCount;
+            assign(static_cast<T_t*>(ptr2.resource), ptr2.control);
             return *this;
         }
-        template <typename R>
-        shared_ptr& operator=(shared_ptr<R>&& ptr2) noexcept {
-            static_assert(is_derived<R>::value, "Can only copy pointers of derived classes!");
-            if(--*refCount == 0)
-                freeResource();
-            resource = static_cast<T_t*>(ptr2.get());
-            refCount = ptr2.get_counter();
-            ++*refCount;
+        template <typename R, typename E>
+        shared_ptr& operator=(shared_ptr<R, E, Policy>&& ptr2) noexcept {
+            shared_ptr(stl::move(ptr2)).swap(*this);
+            return *this;
+        }
+        shared_ptr& operator=(shared_ptr&& ptr2) noexcept {
+            shared_ptr(stl::move(ptr2)).swap(*this);
             return *this;
         }
-        shared_ptr& operator=(const shared_ptr<T>& ptr2) noexcept {
+        shared_ptr& operator=(const shared_ptr& ptr2) noexcept {
             if(this == &ptr2) return *this;
-            if(--*refCount == 0)
-                freeResource();
-            resource = ptr2.get();
-            refCount = ptr2.get_counter();
-            ++*refCount;
+            assign(ptr2.resource, ptr2.control);
             return *this;
         }
 
+        /// Drop the reference (if any) and become empty
+        void reset() {
+            shared_ptr().swap(*this);
+        }
+        /// Drop the reference (if any) and adopt a
+        void reset(T_t* a) {
+            shared_ptr(a).swap(*this);
+        }
+        void swap(shared_ptr& ptr2) noexcept {
+            auto* tmp_resource = resource;
+            auto* tmp_control = control;
+            resource = ptr2.resource;
+            control = ptr2.control;
+            ptr2.resource = tmp_resource;
+            ptr2.control = tmp_control;
+        }
+        /// Take over a reference that has already been counted in control. For make_shared & friends
+        static auto _adopt(T_t* resource, control_block* control) -> shared_ptr {
+            return shared_ptr(resource, control);
+        }
+
     private:
         T_t* resource;
-        uint8_t* refCount;
+        control_block* control;
+
+        shared_ptr(T_t* resource, control_block* control)
+                : resource(resource), control(control) {}
+
+        void acquire() {
+            if(control != nullptr)
+                control->add_strong();
+        }
+        void release() {
+            if(control != nullptr)
+                control->release_strong();
+        }
+        void assign(T_t* new_resource, control_block* new_control) {
+            // Take the new reference first, so assigning a pointer that shares our block is safe
+            if(new_control != nullptr)
+                new_control->add_strong();
+            release();
+            resource = new_resource;
+            control = new_control;
+        }
+    };
+
+    /// Weak pointer class. Non-owning observer of an object managed by shared_ptr.
+    /// It does not keep the object alive, but it keeps the control block allocated,
+    /// so expired() is always safe to ask. Use lock() to get a shared_ptr to the object if it is still alive.
+    /// Usage:
+    /// stl::weak_ptr<driver> cached = stl::make_shared<driver>();
+    /// if(auto d = cached.lock()) d->poll();
+    template<typename T, typename Policy = default_ref_count_policy>
+    class weak_ptr {
+        using T_t = stl::remove_array_t<T>;
+        template<typename R>
+        using is_derived = stl::conditional_t<
+                stl::is_class<stl::remove_array_t<R>>::value,
+                stl::is_base_of<T_t,stl::remove_array_t<R>>,
+                stl::is_same<stl::remove_array_t<T>,stl::remove_array_t<R>>
+        >;
+        using control_block = _shared_control_block<Policy>;
+        template<typename, typename> friend class weak_ptr;
+    public:
+        using counter_type = typename Policy::counter_type;
 
-        void freeResource() {
-            if(resource != nullptr)
-                D{}.free(resource); // Custom deleter instantiation
-            delete refCount;
+        weak_ptr() : resource(nullptr), control(nullptr) {}
+        template<typename R, typename E>
+        weak_ptr(const shared_ptr<R, E, Policy>& ptr2)
+                : resource(static_cast<T_t*>(ptr2.resource)), control(ptr2.control)
+        {
+            static_assert(is_derived<R>::value, "Can only observe pointers of derived classes!");
+            acquire();
+        }
+        weak_ptr(const weak_ptr& ptr2) : resource(ptr2.resource), control(ptr2.control) { acquire(); }
+        template<typename R>
+        weak_ptr(const weak_ptr<R, Policy>& ptr2)
+                : resource(static_cast<T_t*>(ptr2.resource)), control(ptr2.control)
+        {
+            static_assert(is_derived<R>::value, "Can only copy pointers of derived classes!");
+            acquire();
+        }
+        weak_ptr(weak_ptr&& ptr2) noexcept : resource(ptr2.resource), control(ptr2.control) {
+            ptr2.resource = nullptr;
+            ptr2.control = nullptr;
+        }
+        ~weak_ptr() {
+            release();
         }
 
+        auto operator=(const weak_ptr& ptr2) -> weak_ptr& {
+            weak_ptr(ptr2).swap(*this);
+            return *this;
+        }
+        auto operator=(weak_ptr&& ptr2) noexcept -> weak_ptr& {
+            weak_ptr(stl::move(ptr2)).swap(*this);
+            return *this;
+        }
+        template<typename R, typename E>
+        auto operator=(const shared_ptr<R, E, Policy>& ptr2) -> weak_ptr& {
+            weak_ptr(ptr2).swap(*this);
+            return *this;
+        }
+
+        /// Amount of shared_ptrs that own the object, 0 once it has been destroyed
+        inline counter_type use_count() const {
+            if(control == nullptr)
+                return 0;
+            return control->use_count();
+        }
+        inline bool expired() const { return use_count() == 0; }
+        /// A shared_ptr that owns the object, or an empty one if the object has been destroyed already
+        auto lock() const -> shared_ptr<T, default_deleter<T>, Policy> {
+            if(control == nullptr || !control->try_add_strong())
+                return {};
+            return shared_ptr<T, default_deleter<T>, Policy>::_adopt(resource, control);
+        }
+        void reset() {
+            weak_ptr().swap(*this);
+        }
+        void swap(weak_ptr& ptr2) noexcept {
+            auto* tmp_resource = resource;
+            auto* tmp_control = control;
+            resource = ptr2.resource;
+            control = ptr2.control;
+            ptr2.resource = tmp_resource;
+            ptr2.control = tmp_control;
+        }
+
+    private:
+        T_t* resource;
+        control_block* control;
+
+        void acquire() {
+            if(control != nullptr)
+                control->add_weak();
+        }
+        void release() {
+            if(control != nullptr)
+                control->release_weak();
+        }
     };
 
-    template<typename T, typename... Ts>
-    inline auto make_shared(Ts&&... params) -> shared_ptr<T> {
-        return shared_ptr<T>(new T(stl::forward<Ts>(params)...));
+    /// Like make_shared, but the object and its control block are allocated from `allocator`
+    /// Usage:
+    /// auto p = stl::allocate_shared<message>(stl::arena_allocator<message>{frame_arena}, id, payload);
+    template<typename T, typename Policy = default_ref_count_policy, typename Alloc, typename... Ts>
+    inline auto allocate_shared(const Alloc& allocator, Ts&&... params) -> shared_ptr<T, default_deleter<T>, Policy> {
+        auto* block = _shared_inplace_block<T, 1, Policy, Alloc>::create(allocator);
+        new(block->get()) T(stl::forward<Ts>(params)...);
+        return shared_ptr<T, default_deleter<T>, Policy>::_adopt(block->get(), block);
+    }
+
+    template<typename T, typename Policy = default_ref_count_policy, typename... Ts>
+    inline auto make_shared(Ts&&... params) -> shared_ptr<T, default_deleter<T>, Policy> {
+        return allocate_shared<T, Policy>(stl::allocator<T>{}, stl::forward<Ts>(params)...);
     }
 
-    template <typename T, typename... Ts>
-    inline auto make_shared_array(Ts&&... p) -> stl::shared_ptr<T[]> {
-        return stl::shared_ptr<T[]>(new T[sizeof...(p)] {p...});
+    template <typename T, typename Policy = default_ref_count_policy, typename... Ts>
+    inline auto make_shared_array(Ts&&... p) -> stl::shared_ptr<T[], default_deleter<T[]>, Policy> {
+        auto* block = _shared_inplace_block<T, sizeof...(p), Policy>::create(stl::allocator<T>{});
+        size_t i = 0;
+        ((new(block->get() + i++) T(stl::forward<Ts>(p))), ...);
+        return stl::shared_ptr<T[], default_deleter<T[]>, Policy>::_adopt(block->get(), block);
     }
 }
 
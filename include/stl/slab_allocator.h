@@ -0,0 +1,114 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_SLAB_ALLOCATOR_H
+#define AVRCPP_SLAB_ALLOCATOR_H
+#include "default_includes"
+
+namespace stl {
+    /// Header-less allocator for small objects that relies on sized deallocation. Blocks of up to MaxBytes
+    /// are carved from malloc'd slabs of SlabBlocks blocks, with one size class per multiple of sizeof(void*).
+    /// deallocate(p, bytes) finds the class from the size the caller passes back (like the sized
+    /// operator delete does), so the blocks themselves carry no header at all. Only the slabs pay for a
+    /// malloc header and a link, once per SlabBlocks objects.
+    /// Freed blocks stay in their class for reuse. Slabs are only given back to malloc by release().
+    /// Can be constant initialized, so a global instance is usable from static constructors.
+    template<size_t MaxBytes, size_t SlabBlocks>
+    class slab_allocator {
+        static constexpr size_t granule = sizeof(void*); // a free block holds the free-list link
+        static constexpr size_t class_count = MaxBytes / granule + (MaxBytes % granule != 0);
+        static_assert(MaxBytes > 0 && SlabBlocks > 0, "slabs need at least one block of at least one byte");
+        struct free_block { free_block* next; };
+        struct slab { slab* next; size_t block_size; }; // followed by SlabBlocks blocks of block_size
+    public:
+        static constexpr size_t max_bytes = class_count * granule;
+
+        constexpr slab_allocator() : free_lists{}, slabs{nullptr} {}
+        slab_allocator(const slab_allocator&) = delete;
+        auto operator=(const slab_allocator&) -> slab_allocator& = delete;
+
+        /// A block of at least `bytes`, or nullptr if bytes is larger than max_bytes or a new slab can not be malloc'd
+        auto allocate(size_t bytes) -> void* {
+            if(bytes > max_bytes)
+                return nullptr;
+            auto c = class_of(bytes);
+            if(free_lists[c] == nullptr && !refill(c))
+                return nullptr;
+            auto* block = free_lists[c];
+            free_lists[c] = block->next;
+            return block;
+        }
+        /// bytes must be what p was allocated with (any size mapping to the same class works)
+        void deallocate(void* p, size_t bytes) {
+            auto c = class_of(bytes);
+            auto* block = static_cast<free_block*>(p);
+            block->next = free_lists[c];
+            free_lists[c] = block;
+        }
+        /// The class size p was handed out from, or 0 if p is not from one of our slabs.
+        /// Walks all slabs, so it is only meant for the rare deallocations that come without a size
+        auto block_size_of(const void* p) const -> size_t {
+            auto* c = static_cast<const unsigned char*>(p);
+            for(auto* s = slabs; s != nullptr; s = s->next) {
+                auto* first = reinterpret_cast<const unsigned char*>(s + 1);
+                if(c >= first && c < first + SlabBlocks * s->block_size)
+                    return s->block_size;
+            }
+            return 0;
+        }
+        /// Give all slabs back to malloc. Every block must have been deallocated (or be abandoned)
+        void release() {
+            while(slabs != nullptr) {
+                auto* next = slabs->next;
+                ::free(slabs);
+                slabs = next;
+            }
+            for(auto& f : free_lists)
+                f = nullptr;
+        }
+        auto slab_count() const -> size_t {
+            size_t n = 0;
+            for(auto* s = slabs; s != nullptr; s = s->next)
+                n++;
+            return n;
+        }
+
+    private:
+        static constexpr auto class_of(size_t bytes) -> size_t { return bytes == 0 ? 0 : (bytes - 1) / granule; }
+        auto refill(size_t c) -> bool {
+            auto block_size = (c + 1) * granule;
+            auto* s = static_cast<slab*>(malloc(sizeof(slab) + SlabBlocks * block_size));
+            if(s == nullptr)
+                return false;
+            s->next = slabs;
+            s->block_size = block_size;
+            slabs = s;
+            auto* first = reinterpret_cast<unsigned char*>(s + 1);
+            for(auto i = SlabBlocks; i-- > 0;) {
+                auto* block = reinterpret_cast<free_block*>(first + i * block_size);
+                block->next = free_lists[c];
+                free_lists[c] = block;
+            }
+            return true;
+        }
+
+        free_block* free_lists[class_count];
+        slab* slabs;
+    };
+}
+
+#endif
@@ -0,0 +1,375 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_SMALL_VECTOR_H
+#define AVRCPP_SMALL_VECTOR_H
+#include "default_includes"
+#include "uninitialized.h"
+#include "growth_policy.h"
+#include "../utility"
+
+namespace stl {
+    /// Vector that keeps up to N elements in an inline buffer and only allocates
+    /// from the heap once it grows beyond that. The API mirrors stl::vector, including
+    /// the Growth policy (see growth_policy.h) and the SizeT used for the element counters.
+    /// Usage:
+    /// stl::small_vector<int, 8> my_ints;
+    /// stl::small_vector<frame, 4, stl::growth::fixed_step<4>, uint8_t> my_frames;
+    template<typename T, size_t N, typename Growth = growth::doubling, typename SizeT = unsigned int>
+    class small_vector {
+        static_assert(N > 0, "small_vector needs room for at least one inline element");
+        static_assert(N <= static_cast<SizeT>(~SizeT{}), "SizeT can't count the inline elements");
+    public:
+        using value_type = T;
+        using size_type = SizeT;
+        using iterator = T*;
+        using const_iterator = const T*;
+        small_vector();
+        explicit small_vector(size_type size);
+        explicit small_vector(int size);
+        small_vector(size_type size, const T &initial);
+        small_vector(const small_vector<T,N,Growth,SizeT> &v);
+        small_vector(small_vector<T,N,Growth,SizeT>&& v) noexcept;
+        ~small_vector();
+        auto capacity() const -> size_type;
+        auto size() const -> size_type;
+        auto empty() const -> bool;
+        auto is_inline() const -> bool;
+        auto begin() -> iterator;
+        auto begin() const -> iterator;
+        auto end() -> iterator;
+        auto end() const -> iterator;
+        auto front() -> T&;
+        auto back() -> T&;
+        void push_back(const T& value);
+        void push_back(T&& value);
+        template<typename... Args>
+        void emplace_back(Args&&... args);
+        void erase(iterator pos);
+        void erase_index(size_type index);
+        void insert(iterator pos, const T& value);
+        void pop_back();
+        void reserve(size_type new_cap);
+        void shrink_to_fit();
+        void resize(size_type size);
+        auto operator[](size_type index) const -> T&;
+        auto operator=(const small_vector<T,N,Growth,SizeT>&) -> small_vector<T,N,Growth,SizeT>&;
+        auto operator=(small_vector<T,N,Growth,SizeT>&&) noexcept -> small_vector<T,N,Growth,SizeT>&;
+        void clear();
+        auto get() -> const T*;
+    private:
+        auto inline_data() const -> T*;
+        void release_storage();
+        void steal(small_vector<T,N,Growth,SizeT>& v);
+        template<typename... Args>
+        void grow_and_emplace_back(Args&&... args);
+
+        T* data{nullptr};
+        size_type count{};
+        size_type max_count{};
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+    };
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::small_vector()
+            : data{inline_data()}, count{0}, max_count{N}
+    { }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::small_vector(const small_vector<T,N,Growth,SizeT>& v)
+            : small_vector()
+    {
+        reserve(v.count);
+        uninitialized_copy_n(v.data, v.count, data);
+        count = v.count;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::small_vector(small_vector<T,N,Growth,SizeT>&& v) noexcept
+            : small_vector()
+    {
+        steal(v);
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::small_vector(size_type size)
+            : small_vector()
+    {
+        reserve(size);
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::small_vector(int size)
+            : small_vector(static_cast<size_type>(size))
+    { }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::small_vector(size_type size, const T& initial)
+            : small_vector()
+    {
+        reserve(size);
+        uninitialized_fill_n(data, size, initial);
+        count = size;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::operator=(const small_vector<T,N,Growth,SizeT>& v) -> small_vector<T,N,Growth,SizeT>& {
+        if(&v == this)
+            return *this;
+        destroy_n(data, count);
+        count = 0;
+        reserve(v.count);
+        uninitialized_copy_n(v.data, v.count, data);
+        count = v.count;
+        return *this;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::operator=(small_vector<T,N,Growth,SizeT>&& v) noexcept -> small_vector<T,N,Growth,SizeT>& {
+        if(&v == this)
+            return *this;
+        destroy_n(data, count);
+        release_storage();
+        steal(v);
+        return *this;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::steal(small_vector<T,N,Growth,SizeT>& v) {
+        if(v.is_inline()) { // Inline elements can't change owner, so move them over one by one
+            uninitialized_relocate_n(v.data, v.count, data);
+            count = v.count;
+            v.count = 0;
+            return;
+        }
+        count = v.count;
+        max_count = v.max_count;
+        data = v.data;
+        v.data = v.inline_data(); // We own the heap buffer now
+        v.count = 0;
+        v.max_count = N;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::inline_data() const -> T* {
+        return reinterpret_cast<T*>(const_cast<unsigned char*>(buffer));
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::is_inline() const -> bool {
+        return data == inline_data();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::release_storage() {
+        if(!is_inline())
+            deallocate_storage(data, max_count);
+        data = inline_data();
+        max_count = N;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::begin() -> iterator {
+        return data;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::begin() const -> iterator {
+        return data;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::end() -> iterator {
+        return data + size();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::end() const -> iterator {
+        return data + size();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::front() -> T& {
+        return data[0];
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::back() -> T& {
+        return data[count - 1];
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::push_back(const T &v) {
+        emplace_back(v);
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::push_back(T&& v) {
+        emplace_back(stl::move(v));
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    template<typename... Args>
+    void small_vector<T,N,Growth,SizeT>::emplace_back(Args&&... args) {
+        if (count >= max_count) {
+            grow_and_emplace_back(stl::forward<Args>(args)...);
+            return;
+        }
+        new(data + count) T(stl::forward<Args>(args)...);
+        count++;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    template<typename... Args>
+    void small_vector<T,N,Growth,SizeT>::grow_and_emplace_back(Args&&... args) {
+        // The arguments may refer to one of our own elements, so the new element
+        // is constructed before the old buffer is relocated and released.
+        auto new_cap = _next_capacity<Growth>(max_count);
+        auto* new_buffer = allocate_storage<T>(new_cap);
+        new(new_buffer + count) T(stl::forward<Args>(args)...);
+        uninitialized_relocate_n(data, count, new_buffer);
+        release_storage();
+        data = new_buffer;
+        max_count = new_cap;
+        count++;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::pop_back() {
+        if(count <= 0)
+            return;
+        data[--count].~T();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::erase(iterator pos) {
+        if(pos >= end()) { // Erasing end() removes the last element
+            pop_back();
+            return;
+        }
+        for(auto i = pos; i + 1 != end(); ++i)
+            *i = stl::move(*(i + 1));
+        pop_back();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::erase_index(size_type index) {
+        if(index < size())
+            erase(data + index);
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::insert(iterator pos, const T& value) {
+        auto index = static_cast<size_type>(pos - data);
+        if(index >= count) {
+            push_back(value);
+            return;
+        }
+        T v = value; // value may be one of our own elements
+        if(count >= max_count)
+            reserve(_next_capacity<Growth>(max_count));
+
+        new(data + count) T(stl::move(data[count - 1]));
+        for(auto i = count - 1; i > index; i--)
+            data[i] = stl::move(data[i - 1]);
+        data[index] = stl::move(v);
+        count++;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::reserve(size_type new_cap) {
+        if(new_cap <= max_count)
+            return;
+        auto* new_buffer = allocate_storage<T>(new_cap);
+        uninitialized_relocate_n(data, count, new_buffer);
+        release_storage();
+        max_count = new_cap;
+        data = new_buffer;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::shrink_to_fit() {
+        if(is_inline() || count == max_count)
+            return;
+        if(count <= N) { // Everything fits in the inline buffer again
+            auto* heap_buffer = data;
+            auto heap_count = max_count;
+            uninitialized_relocate_n(heap_buffer, count, inline_data());
+            deallocate_storage(heap_buffer, heap_count);
+            data = inline_data();
+            max_count = N;
+            return;
+        }
+        auto* new_buffer = allocate_storage<T>(count);
+        uninitialized_relocate_n(data, count, new_buffer);
+        release_storage();
+        max_count = count;
+        data = new_buffer;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::size() const -> size_type {
+        return count;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::resize(size_type size) {
+        if(size < count) {
+            destroy_n(data + size, count - size);
+            count = size;
+            return;
+        }
+        reserve(size);
+        for(; count < size; count++)
+            new(data + count) T();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::operator[](size_type index) const -> T & {
+        return data[index];
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::capacity() const -> size_type {
+        return max_count;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    small_vector<T,N,Growth,SizeT>::~small_vector() {
+        destroy_n(data, count);
+        release_storage();
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    void small_vector<T,N,Growth,SizeT>::clear() {
+        destroy_n(data, count);
+        release_storage();
+        count = 0;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::get() -> const T* {
+        return data;
+    }
+
+    template<class T, size_t N, class Growth, class SizeT>
+    auto small_vector<T,N,Growth,SizeT>::empty() const -> bool {
+        return count == 0;
+    }
+}
+
+#endif //AVRCPP_SMALL_VECTOR_H
@@ -0,0 +1,187 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_SPSC_QUEUE_H
+#define AVRCPP_SPSC_QUEUE_H
+#include "default_includes"
+#include "algorithm.h"
+#include "atomic.h"
+#include "type_traits.h"
+#include "uninitialized.h"
+#include "../utility"
+
+namespace stl {
+    /// Lock-free single-producer/single-consumer FIFO with a fixed capacity of N (a power of two).
+    /// Meant for handing data from an ISR to the main loop (or between two threads on the host)
+    /// without disabling interrupts: the producer only ever writes `tail` and the consumer only
+    /// ever writes `head`. Both indices run freely and wrap on overflow, so all N slots are usable,
+    /// and they use the narrowest type that can hold 2N - on AVR that must be a single byte (N <= 128).
+    /// Exactly one context may call the producer side (push*, emplace) and one the consumer side (pop*).
+    /// Usage:
+    /// stl::spsc_queue<uint8_t, 64> uart_rx;
+    /// ISR(USART_RX_vect) { uart_rx.push(UDR0); }
+    /// int main() { uint8_t c; while(true) if(uart_rx.pop(c)) handle(c); }
+    template<typename T, size_t N>
+    class spsc_queue {
+        static_assert(N > 0 && (N & (N - 1)) == 0, "spsc_queue capacity must be a power of two");
+    public:
+        using value_type = T;
+        using index_type = stl::smallest_uint_t<2 * N - 1>;
+        static_assert(sizeof(index_type) <= sizeof(stl::lock_free_uint_t),
+                      "spsc_queue indices would not be atomic on this target, reduce N");
+
+        spsc_queue();
+        spsc_queue(const spsc_queue&) = delete;
+        auto operator=(const spsc_queue&) -> spsc_queue& = delete;
+        ~spsc_queue();
+
+        static constexpr auto capacity() -> size_t { return N; }
+        /// Exact from either side while the other side is idle, otherwise a snapshot
+        auto size() const -> size_t;
+        auto empty() const -> bool;
+        auto full() const -> bool;
+
+        //// Producer side
+        auto push(const T& v) -> bool;
+        auto push(T&& v) -> bool;
+        template<typename... Args>
+        auto emplace(Args&&... args) -> bool;
+        /// Enqueue up to n elements from src with a single index publication.
+        /// Returns the amount of elements that were enqueued
+        auto push_n(const T* src, size_t n) -> size_t;
+
+        //// Consumer side
+        /// Move the oldest element into out. Returns false if the queue was empty
+        auto pop(T& out) -> bool;
+        /// Dequeue up to n elements into dst with a single index publication.
+        /// Returns the amount of elements that were dequeued
+        auto pop_n(T* dst, size_t n) -> size_t;
+
+    private:
+        static constexpr auto wrap(index_type i) -> size_t { return static_cast<size_t>(i & (N - 1)); }
+        auto data() -> T*;
+
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+        index_type head; // written by the consumer only
+        index_type tail; // written by the producer only
+    };
+
+    template<typename T, size_t N>
+    spsc_queue<T,N>::spsc_queue() : head{0}, tail{0} { }
+
+    template<typename T, size_t N>
+    spsc_queue<T,N>::~spsc_queue() {
+        if constexpr(!stl::is_trivially_destructible<T>::value) {
+            for(auto i = head; i != tail; i++)
+                data()[wrap(i)].~T();
+        }
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::data() -> T* {
+        return reinterpret_cast<T*>(buffer);
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::size() const -> size_t {
+        auto t = atomic_load(&tail, memory_order::acquire);
+        auto h = atomic_load(&head, memory_order::acquire);
+        return static_cast<index_type>(t - h);
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::empty() const -> bool {
+        return size() == 0;
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::full() const -> bool {
+        return size() == N;
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::push(const T& v) -> bool {
+        return emplace(v);
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::push(T&& v) -> bool {
+        return emplace(stl::move(v));
+    }
+
+    template<typename T, size_t N>
+    template<typename... Args>
+    auto spsc_queue<T,N>::emplace(Args&&... args) -> bool {
+        auto t = atomic_load(&tail, memory_order::relaxed);
+        auto h = atomic_load(&head, memory_order::acquire); // slot must be vacated before we reuse it
+        if(static_cast<index_type>(t - h) == N)
+            return false;
+        new(data() + wrap(t)) T(stl::forward<Args>(args)...);
+        atomic_store(&tail, static_cast<index_type>(t + 1), memory_order::release);
+        return true;
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::push_n(const T* src, size_t n) -> size_t {
+        auto t = atomic_load(&tail, memory_order::relaxed);
+        auto h = atomic_load(&head, memory_order::acquire);
+        n = stl::min(n, N - static_cast<index_type>(t - h));
+        // At most two contiguous segments: up to the end of the buffer, then from the start
+        auto first_segment = stl::min(n, N - wrap(t));
+        uninitialized_copy_n(src, first_segment, data() + wrap(t));
+        uninitialized_copy_n(src + first_segment, n - first_segment, data());
+        atomic_store(&tail, static_cast<index_type>(t + n), memory_order::release);
+        return n;
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::pop(T& out) -> bool {
+        auto h = atomic_load(&head, memory_order::relaxed);
+        auto t = atomic_load(&tail, memory_order::acquire); // element must be fully written before we read it
+        if(h == t)
+            return false;
+        auto* element = data() + wrap(h);
+        out = stl::move(*element);
+        if constexpr(!stl::is_trivially_destructible<T>::value)
+            element->~T();
+        atomic_store(&head, static_cast<index_type>(h + 1), memory_order::release);
+        return true;
+    }
+
+    template<typename T, size_t N>
+    auto spsc_queue<T,N>::pop_n(T* dst, size_t n) -> size_t {
+        auto h = atomic_load(&head, memory_order::relaxed);
+        auto t = atomic_load(&tail, memory_order::acquire);
+        n = stl::min(n, static_cast<size_t>(static_cast<index_type>(t - h)));
+        auto first_segment = stl::min(n, N - wrap(h));
+        // dst is assumed to hold live objects, so this is an assignment rather than a construction
+        if constexpr(stl::is_trivially_copyable<T>::value) {
+            memcpy((void*)dst, (const void*)(data() + wrap(h)), first_segment * sizeof(T));
+            memcpy((void*)(dst + first_segment), (const void*)data(), (n - first_segment) * sizeof(T));
+        } else {
+            for(size_t i = 0; i < n; i++) {
+                auto* element = data() + wrap(static_cast<index_type>(h + i));
+                dst[i] = stl::move(*element);
+                element->~T();
+            }
+        }
+        atomic_store(&head, static_cast<index_type>(h + n), memory_order::release);
+        return n;
+    }
+}
+
+#endif
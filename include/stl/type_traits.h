@@ -136,6 +136,22 @@ namespace stl {
                     stl::false_type
             > { };
 
+    // These need compiler support, so we lean on the gcc builtins (avr-g++ has them too)
+    template<typename T>
+    struct is_trivially_copyable : stl::integral_constant<bool, __is_trivially_copyable(T)> { };
+    template<typename T>
+    struct is_empty : stl::integral_constant<bool, __is_empty(T)> { };
+    template<typename T>
+    struct is_final : stl::integral_constant<bool, __is_final(T)> { };
+    template<typename T>
+    struct is_trivially_destructible : stl::integral_constant<bool, __has_trivial_destructor(T)> { };
+
+    /// Smallest unsigned integer type that can represent the value N
+    template<size_t N>
+    using smallest_uint_t = stl::conditional_t<(N <= 0xFFu), uint8_t,
+                            stl::conditional_t<(N <= 0xFFFFu), uint16_t,
+                            stl::conditional_t<(N <= 0xFFFFFFFFu), uint32_t, size_t>>>;
+
     template<class T> struct is_lvalue_reference     : stl::false_type {};
     template<class T> struct is_lvalue_reference<T&> : stl::true_type {};
 
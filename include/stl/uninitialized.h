@@ -0,0 +1,81 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_UNINITIALIZED_H
+#define AVRCPP_UNINITIALIZED_H
+#include "default_includes"
+#include "../utility"
+
+namespace stl {
+    //// Helpers for containers that manage raw (uninitialized) storage themselves.
+    //// Elements are constructed with placement new and destroyed explicitly, so
+    //// unused capacity never pays for a constructor call.
+    template<typename T>
+    inline auto allocate_storage(size_t n) -> T* {
+        if(n == 0)
+            return nullptr;
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    template<typename T>
+    inline void deallocate_storage(T* p, size_t n) {
+        if(p != nullptr)
+            ::operator delete(p, n * sizeof(T));
+    }
+
+    template<typename T>
+    inline void destroy_n(T* first, size_t n) {
+        if constexpr(stl::is_trivially_destructible<T>::value)
+            return;
+        for(size_t i = 0; i < n; i++)
+            first[i].~T();
+    }
+
+    template<typename T>
+    inline void uninitialized_copy_n(const T* src, size_t n, T* dst) {
+        if constexpr(stl::is_trivially_copyable<T>::value) {
+            if(n != 0)
+                memcpy((void*)dst, (const void*)src, n * sizeof(T));
+            return;
+        }
+        for(size_t i = 0; i < n; i++)
+            new(dst + i) T(src[i]);
+    }
+
+    template<typename T>
+    inline void uninitialized_fill_n(T* dst, size_t n, const T& value) {
+        for(size_t i = 0; i < n; i++)
+            new(dst + i) T(value);
+    }
+
+    /// Move n elements from src into the uninitialized dst and end the lifetime of the originals.
+    /// Trivially copyable types are simply memcpy'ed.
+    template<typename T>
+    inline void uninitialized_relocate_n(T* src, size_t n, T* dst) {
+        if constexpr(stl::is_trivially_copyable<T>::value) {
+            if(n != 0)
+                memcpy((void*)dst, (const void*)src, n * sizeof(T));
+            return;
+        }
+        for(size_t i = 0; i < n; i++) {
+            new(dst + i) T(stl::move(src[i]));
+            src[i].~T();
+        }
+    }
+}
+
+#endif //AVRCPP_UNINITIALIZED_H
@@ -11,21 +11,61 @@
  *
  *  You should have received a copy of the GNU General Public License
  *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
- * 
- * 
+ *
+ *
  * original author: sillydan1 <https://github.com/sillydan1>
  * */
 #ifndef UNIQUE_PTR_HPP
 #define UNIQUE_PTR_HPP
+#include "allocator.h"
 #include "default_deleters.h"
 #include "../utility"
 
 namespace stl {
+    namespace detail {
+        template<typename D, typename P, typename = void>
+        struct has_free_member : stl::false_type {};
+        template<typename D, typename P>
+        struct has_free_member<D, P, stl::void_t<decltype(stl::declval<D&>().free(stl::declval<P>()))>> : stl::true_type {};
+
+        /// Deleters either provide free(p) (like default_deleter) or are callable (function pointers, lambdas)
+        template<typename D, typename P>
+        inline void invoke_deleter(D& d, P p) {
+            if constexpr(has_free_member<D, P>::value)
+                d.free(p);
+            else
+                d(p);
+        }
+
+        /// Pointer + deleter pair. Empty deleters are folded away through the empty base optimization,
+        /// everything else (stateful functors, function pointers) is stored next to the pointer
+        template<typename P, typename D, bool = stl::is_empty<D>::value && !stl::is_final<D>::value>
+        struct unique_ptr_storage : private D {
+            P ptr;
+            constexpr unique_ptr_storage(P ptr, const D& d) : D(d), ptr(ptr) {}
+            constexpr unique_ptr_storage(P ptr, D&& d) : D(stl::move(d)), ptr(ptr) {}
+            auto deleter() -> D& { return *this; }
+            auto deleter() const -> const D& { return *this; }
+        };
+        template<typename P, typename D>
+        struct unique_ptr_storage<P, D, false> {
+            P ptr;
+            D d;
+            constexpr unique_ptr_storage(P ptr, const D& d) : ptr(ptr), d(d) {}
+            constexpr unique_ptr_storage(P ptr, D&& d) : ptr(ptr), d(stl::move(d)) {}
+            auto deleter() -> D& { return d; }
+            auto deleter() const -> const D& { return d; }
+        };
+    }
+
     /// Unique pointer class. Pointer with unique ownership of
     /// the resource. You can define custom deleters via the second
-    /// template argument.
+    /// template argument: either a type with a free(T*) member (see default_deleter)
+    /// or something callable like a function pointer. Stateless deleters take up no space,
+    /// so unique_ptr<T> is exactly as big as T*.
     /// Usage:
     /// unique_ptr<int> my_int_pointer;
+    /// unique_ptr<frame, void(*)(frame*)> pooled{pool.take(), &pool_give_back};
     template <typename T, typename D = default_deleter<T>>
     class unique_ptr {
         using T_t = stl::remove_array_t<T>;
@@ -35,51 +75,92 @@ namespace stl {
                 stl::is_base_of<T_t,stl::remove_array_t<R>>,
                 stl::is_same<stl::remove_array_t<T>,stl::remove_array_t<R>>
         >;
+        template<typename, typename> friend class unique_ptr;
     public:
-        unique_ptr() = delete;
+        using pointer = T_t*;
+        using deleter_type = D;
+
+        constexpr unique_ptr() : storage(nullptr, D{}) {}
+        constexpr unique_ptr(decltype(nullptr)) : storage(nullptr, D{}) {}
+        unique_ptr(T_t* a) : storage(a, D{}) {}
+        unique_ptr(T_t* a, const D& d) : storage(a, d) {}
+        unique_ptr(T_t* a, D&& d) : storage(a, stl::move(d)) {}
         unique_ptr(const unique_ptr& other) = delete;
-        template<typename R>
-        unique_ptr(unique_ptr<R>&& ptr2)
-                : resource(static_cast<T_t*>(ptr2.get()))
+        unique_ptr(unique_ptr&& ptr2) noexcept
+                : storage(ptr2.release(), stl::move(ptr2.get_deleter()))
+        { }
+        template<typename R, typename E>
+        unique_ptr(unique_ptr<R, E>&& ptr2)
+                : storage(static_cast<T_t*>(ptr2.release()), D(stl::move(ptr2.get_deleter())))
         { static_assert(is_derived<R>::value, "Can only move pointers of derived classes!"); }
-        unique_ptr(T_t* a) : resource(a) {}
         ~unique_ptr() {
-            if(resource != NULL)
-                freeResource();
+            static_assert(!stl::is_empty<D>::value || sizeof(unique_ptr) == sizeof(T_t*),
+                          "Stateless deleters should not take up any space");
+            if(storage.ptr != nullptr)
+                detail::invoke_deleter(storage.deleter(), storage.ptr);
         }
         unique_ptr<T,D>& operator=(const unique_ptr<T, D> &ptr2) = delete;
+        unique_ptr& operator=(unique_ptr&& ptr2) noexcept {
+            reset(ptr2.release());
+            storage.deleter() = stl::move(ptr2.get_deleter());
+            return *this;
+        }
+        template<typename R, typename E>
+        unique_ptr& operator=(unique_ptr<R, E>&& ptr2) noexcept {
+            static_assert(is_derived<R>::value, "Can only move pointers of derived classes!");
+            reset(static_cast<T_t*>(ptr2.release()));
+            storage.deleter() = D(stl::move(ptr2.get_deleter()));
+            return *this;
+        }
+        unique_ptr& operator=(decltype(nullptr)) noexcept {
+            reset();
+            return *this;
+        }
 
         inline T* operator->() const {
             static_assert(!stl::is_array<T>::value,
                           "'->' operator does not work for pointers to arrays!");
-            return resource;
+            return storage.ptr;
         }
         inline T& operator*() const {
             static_assert(!stl::is_array<T>::value,
                           "'*' operator does not work for pointers to arrays!");
-            return *resource;
+            return *storage.ptr;
         }
         inline T_t& operator[](const unsigned int i) const {
             static_assert(stl::is_array<T>::value,
                           "'[]' operator only works for pointers to arrays!");
-            return resource[i];
+            return storage.ptr[i];
         }
-        inline T_t* const get() const { return resource; }
-        template<typename R>
-        unique_ptr& operator=(unique_ptr<R>&& ptr) noexcept {
-            static_assert(is_derived<R>::value, "Can only move pointers of derived classes!");
-            if (resource != NULL)
-                freeResource();
-            resource = ptr.resource; /* "move" ownership of the resource to us */
-            ptr.resource = NULL;
-            return *this;
+        inline T_t* get() const { return storage.ptr; }
+        inline D& get_deleter() { return storage.deleter(); }
+        inline const D& get_deleter() const { return storage.deleter(); }
+        explicit operator bool() const { return storage.ptr != nullptr; }
+
+        /// Give up ownership without freeing the resource. The caller is now responsible for it
+        auto release() -> T_t* {
+            auto* p = storage.ptr;
+            storage.ptr = nullptr;
+            return p;
+        }
+        /// Take ownership of a and free the previously owned resource (if any)
+        void reset(T_t* a = nullptr) {
+            auto* old = storage.ptr;
+            storage.ptr = a;
+            if(old != nullptr)
+                detail::invoke_deleter(storage.deleter(), old);
+        }
+        void swap(unique_ptr& ptr2) noexcept {
+            auto* tmp = storage.ptr;
+            storage.ptr = ptr2.storage.ptr;
+            ptr2.storage.ptr = tmp;
+            auto tmp_deleter = stl::move(storage.deleter());
+            storage.deleter() = stl::move(ptr2.storage.deleter());
+            ptr2.storage.deleter() = stl::move(tmp_deleter);
         }
 
     private:
-        T_t* resource;
-        void freeResource() {
-            D{}.free(resource);
-        }
+        detail::unique_ptr_storage<T_t*, D> storage;
     };
 
     template<class T, class... Args>
@@ -89,11 +170,36 @@ namespace stl {
 
     template<class T>
     auto make_unique(size_t n) -> stl::enable_if_t<detail::is_unbounded_array_v<T>, stl::unique_ptr<T>> {
-        return stl::unique_ptr<T>(new stl::remove_array<T>[n]());
+        return stl::unique_ptr<T>(new stl::remove_array_t<T>[n]());
     }
 
     template<class T, class... Args>
     auto make_unique(Args&&...) -> stl::enable_if_t<detail::is_bounded_array_v<T>> = delete;
+
+    /// Deleter for allocate_unique. Destroys the object and hands its storage back to the allocator.
+    /// Stateless allocators keep the unique_ptr as small as a raw pointer
+    template<typename Alloc>
+    class allocator_delete : private _allocator_holder<Alloc> {
+    public:
+        using value_type = typename Alloc::value_type;
+        explicit allocator_delete(const Alloc& allocator) : _allocator_holder<Alloc>{allocator} {}
+        void operator()(value_type* p) {
+            p->~value_type();
+            this->alloc().deallocate(p, 1);
+        }
+        auto get_allocator() const -> Alloc { return this->alloc(); }
+    };
+
+    /// Like make_unique, but the object is allocated from `allocator`
+    /// Usage:
+    /// auto job = stl::allocate_unique<job_t>(stl::pool_allocator<job_t, job_pool_t>{job_pool}, args...);
+    template<class T, class Alloc, class... Args>
+    auto allocate_unique(const Alloc& allocator, Args&&... args)
+            -> stl::enable_if_t<!stl::is_array<T>::value, stl::unique_ptr<T, allocator_delete<allocator_rebind_t<Alloc, T>>>> {
+        allocator_rebind_t<Alloc, T> a{allocator};
+        auto* p = new(a.allocate(1)) T(stl::forward<Args>(args)...);
+        return stl::unique_ptr<T, allocator_delete<allocator_rebind_t<Alloc, T>>>(p, allocator_delete<allocator_rebind_t<Alloc, T>>{a});
+    }
 }
 
 #endif // UNIQUE_PTR_HPP
@@ -18,24 +18,42 @@
 #ifndef AVRCPP_VECTOR_H
 #define AVRCPP_VECTOR_H
 #include "default_includes"
+#include "uninitialized.h"
+#include "growth_policy.h"
+#include "allocator.h"
 #include "../utility"
 
 namespace stl {
-    template<typename T>
-    class vector {
+    /// Contiguous, growable array. Storage is kept uninitialized until an element is
+    /// actually constructed in it, so spare capacity never runs any constructors.
+    /// The second template argument selects how the capacity grows (see growth_policy.h),
+    /// and the third the integer type used for the element counters. Pick uint8_t or uint16_t
+    /// for small vectors to save RAM and cheapen the arithmetic on 8-bit cores.
+    /// The storage comes from the Allocator (see allocator.h), the global heap by default.
+    /// Usage:
+    /// stl::vector<int> my_ints;
+    /// stl::vector<frame, stl::growth::fixed_step<4>, uint8_t> my_frames;
+    /// stl::vector<int, stl::growth::doubling, uint8_t, stl::arena_allocator<int>> scratch{stl::arena_allocator<int>{frame_arena}};
+    template<typename T, typename Growth = growth::doubling, typename SizeT = unsigned int, typename Allocator = stl::allocator<T>>
+    class vector : private _allocator_holder<Allocator> {
         static constexpr size_t default_capacity = 1;
     public:
+        using value_type = T;
+        using size_type = SizeT;
         using iterator = T*;
         using const_iterator = const T*;
+        using allocator_type = Allocator;
         vector();
-        explicit vector(unsigned int size);
-        explicit vector(int size);
-        vector(unsigned int size, const T &initial);
-        vector(const vector <T> &v);
-        vector(vector<T>&& v) noexcept;
+        explicit vector(const Allocator& allocator);
+        explicit vector(size_type size, const Allocator& allocator = Allocator{});
+        explicit vector(int size, const Allocator& allocator = Allocator{});
+        vector(size_type size, const T &initial, const Allocator& allocator = Allocator{});
+        vector(const vector<T,Growth,SizeT,Allocator> &v);
+        vector(vector<T,Growth,SizeT,Allocator>&& v) noexcept;
         ~vector();
-        auto capacity() const -> unsigned int;
-        auto size() const -> unsigned int;
+        static constexpr auto max_size() -> size_type { return static_cast<size_type>(~size_type{}); }
+        auto capacity() const -> size_type;
+        auto size() const -> size_type;
         auto empty() const -> bool;
         auto begin() -> iterator;
         auto begin() const -> iterator;
@@ -44,232 +62,314 @@ namespace stl {
         auto front() -> T&;
         auto back() -> T&;
         void push_back(const T& value);
-        void emplace_back(T&& value);
+        void push_back(T&& value);
+        template<typename... Args>
+        void emplace_back(Args&&... args);
         void erase(iterator pos);
-        void erase_index(unsigned int index);
+        void erase_index(size_type index);
         void insert(iterator pos, const T& value);
         void pop_back();
-        void reserve(unsigned int new_cap);
-        void resize(unsigned int size);
-        auto operator[](unsigned int index) const -> T&;
-        auto operator=(const vector<T>&) -> vector<T>&;
-        auto operator=(vector<T>&&) noexcept -> vector<T>&;
+        void reserve(size_type new_cap);
+        void shrink_to_fit();
+        void resize(size_type size);
+        auto operator[](size_type index) const -> T&;
+        auto operator=(const vector<T,Growth,SizeT,Allocator>&) -> vector<T,Growth,SizeT,Allocator>&;
+        auto operator=(vector<T,Growth,SizeT,Allocator>&&) noexcept -> vector<T,Growth,SizeT,Allocator>&;
         void clear();
-        auto get() -> const T* const;
+        auto get() -> const T*;
+        auto get_allocator() const -> Allocator { return this->alloc(); }
     private:
-        unsigned int count{};
-        unsigned int max_count{};
+        auto allocate_storage(size_t n) -> T* { return n == 0 ? nullptr : this->alloc().allocate(n); }
+        void deallocate_storage(T* p, size_t n) {
+            if(p != nullptr)
+                this->alloc().deallocate(p, n);
+        }
+        auto next_capacity() const -> size_type;
+        template<typename... Args>
+        void grow_and_emplace_back(Args&&... args);
+
         T* data{nullptr};
+        size_type count{};
+        size_type max_count{};
     };
 
-    template<class T>
-    vector<T>::vector()
-            : count{0}, max_count{default_capacity}, data{new T[default_capacity]}
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector()
+            : vector(Allocator{})
     { }
 
-    template<class T>
-    vector<T>::vector(const vector<T>& v)
-            : count{v.count}, max_count{v.max_count}, data{new T[v.max_count]}
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector(const Allocator& allocator)
+            : _allocator_holder<Allocator>{allocator}, data{allocate_storage(default_capacity)}, count{0}, max_count{default_capacity}
+    { }
+
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector(const vector<T,Growth,SizeT,Allocator>& v)
+            : _allocator_holder<Allocator>{v.alloc()}, data{allocate_storage(v.max_count)}, count{v.count}, max_count{v.max_count}
     {
-        for (unsigned int i = 0; i < v.count; i++)
-            data[i] = v.data[i];
+        uninitialized_copy_n(v.data, v.count, data);
     }
 
-    template<class T>
-    vector<T>::vector(vector<T>&& v) noexcept
-            : count{v.count}, max_count{v.max_count}, data{v.data}
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector(vector<T,Growth,SizeT,Allocator>&& v) noexcept
+            : _allocator_holder<Allocator>{v.alloc()}, data{v.data}, count{v.count}, max_count{v.max_count}
     {
         v.data = nullptr; // We own the resource now
+        v.count = 0;
+        v.max_count = 0;
     }
 
-    template<class T>
-    vector<T>::vector(unsigned int size)
-            : count{0}, max_count{size}, data{new T[size]}
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector(size_type size, const Allocator& allocator)
+            : _allocator_holder<Allocator>{allocator}, data{allocate_storage(size)}, count{0}, max_count{size}
     { }
 
-    template<class T>
-    vector<T>::vector(int size)
-            : count{0}, max_count{static_cast<unsigned int>(size)}, data{new T[size]}
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector(int size, const Allocator& allocator)
+            : _allocator_holder<Allocator>{allocator}, data{allocate_storage(size)}, count{0}, max_count{static_cast<size_type>(size)}
     { }
 
-    template<class T>
-    vector<T>::vector(unsigned int size, const T& initial)
-            : count{size}, max_count{size}, data{new T[size]}
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::vector(size_type size, const T& initial, const Allocator& allocator)
+            : _allocator_holder<Allocator>{allocator}, data{allocate_storage(size)}, count{size}, max_count{size}
     {
-        for (unsigned int i = 0; i < size; i++)
-            data[i] = initial;
+        uninitialized_fill_n(data, size, initial);
     }
 
-    template<class T>
-    auto vector<T>::operator=(const vector<T>& v) -> vector<T>& {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::operator=(const vector<T,Growth,SizeT,Allocator>& v) -> vector<T,Growth,SizeT,Allocator>& {
         if(&v == this)
             return *this;
-        delete[] data;
+        destroy_n(data, count);
+        deallocate_storage(data, max_count);
         count = v.count;
         max_count = v.max_count;
-        data = new T[count];
-        for (unsigned int i = 0; i < count; i++)
-            data[i] = v.data[i];
+        data = allocate_storage(max_count);
+        uninitialized_copy_n(v.data, count, data);
         return *this;
     }
 
-    template<class T>
-    auto vector<T>::operator=(vector<T>&& v)  noexcept -> vector<T>& {
-        delete[] data;
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::operator=(vector<T,Growth,SizeT,Allocator>&& v)  noexcept -> vector<T,Growth,SizeT,Allocator>& {
+        if(&v == this)
+            return *this;
+        if(!_allocators_equal(this->alloc(), v.alloc())) {
+            // v's storage can not be freed through our allocator, so move the elements over instead
+            clear();
+            reserve(v.count);
+            for(; count < v.count; count++)
+                new(data + count) T(stl::move(v.data[count]));
+            v.clear();
+            return *this;
+        }
+        destroy_n(data, count);
+        deallocate_storage(data, max_count);
         count = v.count;
         max_count = v.max_count;
         data = v.data;
         v.data = nullptr; // We own the resource now
+        v.count = 0;
+        v.max_count = 0;
         return *this;
     }
 
-    template<class T>
-    auto vector<T>::begin() -> typename vector<T>::iterator {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::begin() -> typename vector<T,Growth,SizeT,Allocator>::iterator {
         return data;
     }
 
-    template<class T>
-    auto vector<T>::begin() const -> typename vector<T>::iterator {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::begin() const -> typename vector<T,Growth,SizeT,Allocator>::iterator {
         return data;
     }
 
-    template<class T>
-    auto vector<T>::end() -> typename vector<T>::iterator {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::end() -> typename vector<T,Growth,SizeT,Allocator>::iterator {
         return data + size();
     }
 
-    template<class T>
-    auto vector<T>::end() const -> typename vector<T>::iterator {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::end() const -> typename vector<T,Growth,SizeT,Allocator>::iterator {
         return data + size();
     }
 
-    template<class T>
-    auto vector<T>::front() -> T& {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::front() -> T& {
         return data[0];
     }
 
-    template<class T>
-    auto vector<T>::back() -> T& {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::back() -> T& {
         return data[count - 1];
     }
 
-    template<class T>
-    void vector<T>::push_back(const T &v) {
-        if (count >= max_count)
-            reserve(max_count << 1u);
-        data[count++] = v;
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::push_back(const T &v) {
+        emplace_back(v);
+    }
+
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::push_back(T&& v) {
+        emplace_back(stl::move(v));
     }
 
-    template<class T>
-    void vector<T>::emplace_back(T&& v) {
-        if (count >= max_count)
-            reserve(max_count << 1u);
-        data[count++] = stl::move(v);
+    template<class T, class Growth, class SizeT, class Allocator>
+    template<typename... Args>
+    void vector<T,Growth,SizeT,Allocator>::emplace_back(Args&&... args) {
+        if (count >= max_count) {
+            grow_and_emplace_back(stl::forward<Args>(args)...);
+            return;
+        }
+        new(data + count) T(stl::forward<Args>(args)...);
+        count++;
+    }
+
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::next_capacity() const -> size_type {
+        return _next_capacity<Growth>(max_count);
+    }
+
+    template<class T, class Growth, class SizeT, class Allocator>
+    template<typename... Args>
+    void vector<T,Growth,SizeT,Allocator>::grow_and_emplace_back(Args&&... args) {
+        // The arguments may refer to one of our own elements, so the new element
+        // is constructed before the old buffer is relocated and released.
+        auto new_cap = next_capacity();
+        auto* new_buffer = allocate_storage(new_cap);
+        new(new_buffer + count) T(stl::forward<Args>(args)...);
+        uninitialized_relocate_n(data, count, new_buffer);
+        deallocate_storage(data, max_count);
+        data = new_buffer;
+        max_count = new_cap;
+        count++;
     }
 
-    template<class T>
-    void vector<T>::pop_back() {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::pop_back() {
         if(count <= 0)
             return;
-        data[count--].~T();
+        data[--count].~T();
     }
 
-    template<class T>
-    void vector<T>::erase(iterator pos) {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::erase(iterator pos) {
+        if(pos >= end()) { // Erasing end() removes the last element
+            pop_back();
+            return;
+        }
         for(auto i = pos; i + 1 != end(); ++i)
-            *i = *(i + 1);
+            *i = stl::move(*(i + 1));
         pop_back();
     }
 
-    template<class T>
-    void vector<T>::erase_index(unsigned int index) {
-        if(index == size()-1)
-            pop_back();
-        else if(index < size()-1) {
-            for(auto i = index; i + 1 != size(); ++i)
-                data[i] = data[i+1];
-            pop_back();
-        }
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::erase_index(size_type index) {
+        if(index < size())
+            erase(data + index);
     }
 
-    template<typename T>
-    void vector<T>::insert(iterator pos, const T& value) {
-        if(pos == end()) {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::insert(iterator pos, const T& value) {
+        auto index = static_cast<size_type>(pos - data);
+        if(index >= count) {
             push_back(value);
             return;
         }
+        T v = value; // value may be one of our own elements
         if(count >= max_count)
-            reserve(max_count << 1u);
+            reserve(next_capacity());
 
-        T v = value;
+        new(data + count) T(stl::move(data[count - 1]));
+        for(auto i = count - 1; i > index; i--)
+            data[i] = stl::move(data[i - 1]);
+        data[index] = stl::move(v);
         count++;
-        for(auto it = pos; it != end(); it++) {
-            auto cpy = *it;
-            *it = v;
-            v = cpy;
-        }
     }
 
-    template<class T>
-    void vector<T>::reserve(unsigned int new_cap) {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::reserve(size_type new_cap) {
         if (data == nullptr) {
             count = 0;
             max_count = 0;
         }
         if(new_cap <= max_count)
             return;
-        auto* new_buffer = new T[new_cap];
-        for (unsigned int i = 0; i < count; i++)
-            new_buffer[i] = data[i];
-
+        auto* new_buffer = allocate_storage(new_cap);
+        uninitialized_relocate_n(data, count, new_buffer);
+        deallocate_storage(data, max_count);
         max_count = new_cap;
-        delete[] data;
         data = new_buffer;
     }
 
-    template<class T>
-    auto vector<T>::size() const -> unsigned int {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::shrink_to_fit() {
+        if(count == max_count)
+            return;
+        auto* new_buffer = allocate_storage(count);
+        uninitialized_relocate_n(data, count, new_buffer);
+        deallocate_storage(data, max_count);
+        max_count = count;
+        data = new_buffer;
+    }
+
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::size() const -> size_type {
         return count;
     }
 
-    template<class T>
-    void vector<T>::resize(unsigned int size) {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::resize(size_type size) {
+        if(size < count) {
+            destroy_n(data + size, count - size);
+            count = size;
+            return;
+        }
         reserve(size);
-        count = size;
+        for(; count < size; count++)
+            new(data + count) T();
     }
 
-    template<class T>
-    auto vector<T>::operator[](unsigned int index) const -> T & {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::operator[](size_type index) const -> T & {
         return data[index];
     }
 
-    template<class T>
-    auto vector<T>::capacity() const -> unsigned int {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::capacity() const -> size_type {
         return max_count;
     }
 
-    template<class T>
-    vector<T>::~vector() {
-        delete[] data;
+    template<class T, class Growth, class SizeT, class Allocator>
+    vector<T,Growth,SizeT,Allocator>::~vector() {
+        destroy_n(data, count);
+        deallocate_storage(data, max_count);
     }
 
-    template<class T>
-    void vector<T>::clear() {
+    template<class T, class Growth, class SizeT, class Allocator>
+    void vector<T,Growth,SizeT,Allocator>::clear() {
+        destroy_n(data, count);
+        deallocate_storage(data, max_count);
         max_count = 0;
         count = 0;
-        delete[] data;
         data = nullptr;
     }
 
-    template<class T>
-    auto vector<T>::get() -> const T* const {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::get() -> const T* {
         return data;
     }
 
-    template<class T>
-    auto vector<T>::empty() const -> bool {
+    template<class T, class Growth, class SizeT, class Allocator>
+    auto vector<T,Growth,SizeT,Allocator>::empty() const -> bool {
         return count == 0;
     }
+
+    namespace pmr {
+        template<typename T> class polymorphic_allocator;
+        /// vector whose memory_resource is picked at run time (see memory_resource.h)
+        template<typename T, typename Growth = growth::doubling, typename SizeT = unsigned int>
+        using vector = stl::vector<T, Growth, SizeT, polymorphic_allocator<T>>;
+    }
 }
 
 #endif //AVRCPP_VECTOR_H
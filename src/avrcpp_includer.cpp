@@ -21,6 +21,11 @@
 //// by an implementation file, so I include everything here.
 #include "../include/utility"
 #include "../include/memory"
+#include "../include/memory_resource"
 #include "../include/vector"
+#include "../include/small_vector"
+#include "../include/inplace_vector"
 #include "../include/deque"
+#include "../include/ring_buffer"
+#include "../include/spsc_queue"
 #include "../include/algorithm"
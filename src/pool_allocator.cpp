@@ -0,0 +1,57 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+/*
+ * Size-class pool backing operator new/delete. Only compiled into the avrcpp_pool target.
+ * The arenas are reserved statically (they show up in .bss), tune them with the defines below.
+ * */
+#include "utillities.h"
+#include "../include/stl/pool_allocator.h"
+
+#ifndef AVRCPP_POOL_4_BLOCKS
+#define AVRCPP_POOL_4_BLOCKS 8
+#endif
+#ifndef AVRCPP_POOL_8_BLOCKS
+#define AVRCPP_POOL_8_BLOCKS 16
+#endif
+#ifndef AVRCPP_POOL_16_BLOCKS
+#define AVRCPP_POOL_16_BLOCKS 8
+#endif
+#ifndef AVRCPP_POOL_32_BLOCKS
+#define AVRCPP_POOL_32_BLOCKS 8
+#endif
+
+namespace {
+    // Constant initialized (into .bss), so it is usable from static constructors
+    constinit stl::size_class_allocator<
+            stl::fixed_block_pool<4, AVRCPP_POOL_4_BLOCKS>,
+            stl::fixed_block_pool<8, AVRCPP_POOL_8_BLOCKS>,
+            stl::fixed_block_pool<16, AVRCPP_POOL_16_BLOCKS>,
+            stl::fixed_block_pool<32, AVRCPP_POOL_32_BLOCKS>> default_pool{};
+}
+
+namespace stl {
+    auto pool_allocate(size_t size) -> void* {
+        return default_pool.allocate(size);
+    }
+    void pool_deallocate(void* ptr) {
+        default_pool.deallocate(ptr);
+    }
+    auto pool_fallback_count() -> size_t {
+        return default_pool.fallback_count();
+    }
+}
@@ -0,0 +1,63 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+/*
+ * Header-less small object backend for operator new/delete, built when AVRCPP_SIZED_DEALLOCATION is ON.
+ * Objects of up to AVRCPP_SIZED_MAX_BYTES live in malloc'd slabs and are freed by the size the compiler
+ * passes to the sized operator delete, so they don't pay for a malloc header each.
+ * */
+#include "utillities.h"
+#include "../include/stl/slab_allocator.h"
+
+#ifndef AVRCPP_SIZED_MAX_BYTES
+#define AVRCPP_SIZED_MAX_BYTES 8
+#endif
+#ifndef AVRCPP_SIZED_SLAB_BLOCKS
+#define AVRCPP_SIZED_SLAB_BLOCKS 8
+#endif
+
+namespace {
+    // Constant initialized, so it is usable from static constructors. Never released, since objects
+    // in other translation units may still be deleted during static destruction
+    stl::slab_allocator<AVRCPP_SIZED_MAX_BYTES, AVRCPP_SIZED_SLAB_BLOCKS> small_objects{};
+}
+
+namespace stl {
+    auto sized_allocate(size_t size) -> void* {
+        if(size > small_objects.max_bytes)
+            return malloc(size);
+        return small_objects.allocate(size);
+    }
+    void sized_deallocate(void* ptr, size_t size) {
+        if(ptr == nullptr)
+            return;
+        if(size > small_objects.max_bytes)
+            free(ptr);
+        else
+            small_objects.deallocate(ptr, size);
+    }
+    void sized_deallocate(void* ptr) {
+        if(ptr == nullptr)
+            return;
+        // Deletes of incomplete types arrive without a size. Rare, so finding the slab the slow way is fine
+        auto size = small_objects.block_size_of(ptr);
+        if(size == 0)
+            free(ptr);
+        else
+            small_objects.deallocate(ptr, size);
+    }
+}
@@ -30,27 +30,47 @@ void __cxa_deleted_virtual(void) {
 }
 
 // new/delete allocators
+// Arrays get their own path, since delete[] of trivially destructible elements never receives a size
+#if defined(AVRCPP_USE_POOL_ALLOCATOR)
+#define AVRCPP_ALLOCATE(size) stl::pool_allocate(size)
+#define AVRCPP_DEALLOCATE(ptr) stl::pool_deallocate(ptr)
+#define AVRCPP_DEALLOCATE_SIZED(ptr, size) stl::pool_deallocate(ptr)
+#define AVRCPP_ALLOCATE_ARRAY(size) stl::pool_allocate(size)
+#define AVRCPP_DEALLOCATE_ARRAY(ptr) stl::pool_deallocate(ptr)
+#elif defined(AVRCPP_USE_SIZED_ALLOCATOR)
+#define AVRCPP_ALLOCATE(size) stl::sized_allocate(size)
+#define AVRCPP_DEALLOCATE(ptr) stl::sized_deallocate(ptr)
+#define AVRCPP_DEALLOCATE_SIZED(ptr, size) stl::sized_deallocate(ptr, size)
+#define AVRCPP_ALLOCATE_ARRAY(size) malloc(size)
+#define AVRCPP_DEALLOCATE_ARRAY(ptr) free(ptr)
+#else
+#define AVRCPP_ALLOCATE(size) malloc(size)
+#define AVRCPP_DEALLOCATE(ptr) free(ptr)
+#define AVRCPP_DEALLOCATE_SIZED(ptr, size) free(ptr)
+#define AVRCPP_ALLOCATE_ARRAY(size) malloc(size)
+#define AVRCPP_DEALLOCATE_ARRAY(ptr) free(ptr)
+#endif
 auto operator new(size_t objsize) -> void* {
-	return malloc(objsize);
+	return AVRCPP_ALLOCATE(objsize);
 }
 auto operator new(size_t objsize, void* ptr) -> void* {
     return ptr;
 }
 auto operator new[](size_t objsize) -> void* {
-	return malloc(objsize);
+	return AVRCPP_ALLOCATE_ARRAY(objsize);
 }
 auto operator new[](size_t objsize, void* ptr) -> void* {
     return ptr;
 }
 void operator delete(void* obj) {
-	free(obj);
+	AVRCPP_DEALLOCATE(obj);
 }
 void operator delete(void* obj, size_t size) {
-    free(obj);
+    AVRCPP_DEALLOCATE_SIZED(obj, size);
 }
 void operator delete[](void* obj) {
-	free(obj);
+	AVRCPP_DEALLOCATE_ARRAY(obj);
 }
 void operator delete[](void* obj, size_t size) {
-    free(obj);
+    AVRCPP_DEALLOCATE_ARRAY(obj);
 }
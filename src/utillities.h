@@ -30,4 +30,22 @@ void operator delete(void * ptr);
 void operator delete(void * ptr, size_t size);
 void operator delete[](void * ptr);
 void operator delete[](void * ptr, size_t size);
+#ifdef AVRCPP_USE_POOL_ALLOCATOR
+/* size-class pool behind new/delete (avrcpp_pool target only) */
+namespace stl {
+    auto pool_allocate(size_t size) -> void*;
+    void pool_deallocate(void* ptr);
+    /// Amount of allocations the pools could not serve and passed on to malloc
+    auto pool_fallback_count() -> size_t;
+}
+#endif
+#ifdef AVRCPP_USE_SIZED_ALLOCATOR
+/* header-less small object backend keyed by the sized operator delete (AVRCPP_SIZED_DEALLOCATION only) */
+namespace stl {
+    auto sized_allocate(size_t size) -> void*;
+    void sized_deallocate(void* ptr, size_t size);
+    /// For deletes that come without a size. Looks the block up in the slabs
+    void sized_deallocate(void* ptr);
+}
+#endif
 #endif
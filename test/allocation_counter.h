@@ -0,0 +1,64 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_ALLOCATION_COUNTER_H
+#define AVRCPP_TEST_ALLOCATION_COUNTER_H
+#include <stdlib.h>
+#include <new>
+// Replaces the global new/delete for the test binary, so tests can verify how often
+// (and how much) the containers reach for the heap.
+// Note: gtest itself allocates too, so only compare counters around the code under test.
+namespace test {
+    struct allocation_counter {
+        static inline size_t allocations = 0;
+        static inline size_t deallocations = 0;
+        static inline size_t bytes_allocated = 0;
+        static void reset() {
+            allocations = 0;
+            deallocations = 0;
+            bytes_allocated = 0;
+        }
+    };
+}
+
+auto operator new(size_t size) -> void* {
+    test::allocation_counter::allocations++;
+    test::allocation_counter::bytes_allocated += size;
+    if(auto* p = malloc(size == 0 ? 1 : size))
+        return p;
+    throw std::bad_alloc{};
+}
+auto operator new[](size_t size) -> void* {
+    return ::operator new(size);
+}
+void operator delete(void* ptr) noexcept {
+    if(ptr == nullptr)
+        return;
+    test::allocation_counter::deallocations++;
+    free(ptr);
+}
+void operator delete(void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+void operator delete[](void* ptr) noexcept {
+    ::operator delete(ptr);
+}
+void operator delete[](void* ptr, size_t) noexcept {
+    ::operator delete(ptr);
+}
+
+#endif
@@ -0,0 +1,40 @@
+# Compiles SOURCE to assembly and checks that each unique_<name> function compiles to exactly
+# the same instructions as its raw_<name> counterpart (labels normalized).
+# Usage: cmake -DCOMPILER=<c++> -DSOURCE=<file.cpp> -DFUNCTIONS=deref,destroy -P compare_codegen.cmake
+execute_process(
+        COMMAND ${COMPILER} -std=c++20 -O2 -fno-asynchronous-unwind-tables -S -o - ${SOURCE}
+        OUTPUT_VARIABLE assembly
+        ERROR_VARIABLE errors
+        RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+    message(FATAL_ERROR "Compiling ${SOURCE} failed:\n${errors}")
+endif()
+
+function(extract_function name out)
+    string(FIND "${assembly}" "\n${name}:\n" begin)
+    if(begin EQUAL -1)
+        message(FATAL_ERROR "Function ${name} not found in the assembly")
+    endif()
+    string(SUBSTRING "${assembly}" ${begin} -1 body)
+    string(FIND "${body}" "\t.size\t${name}," end)
+    string(SUBSTRING "${body}" 0 ${end} body)
+    string(REPLACE "\n${name}:\n" "" body "${body}")
+    string(REGEX REPLACE "\\.L[A-Za-z]*[0-9]+" ".L" body "${body}")
+    set(${out} "${body}" PARENT_SCOPE)
+endfunction()
+
+string(REPLACE "," ";" FUNCTIONS "${FUNCTIONS}")
+set(failed FALSE)
+foreach(function ${FUNCTIONS})
+    extract_function(raw_${function} raw)
+    extract_function(unique_${function} unique)
+    if(raw STREQUAL unique)
+        message(STATUS "${function}: identical")
+    else()
+        message(STATUS "${function}: differs\n--- raw_${function}\n${raw}\n--- unique_${function}\n${unique}")
+        set(failed TRUE)
+    endif()
+endforeach()
+if(failed)
+    message(FATAL_ERROR "unique_ptr generates different code than raw pointers")
+endif()
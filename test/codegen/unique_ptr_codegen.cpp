@@ -0,0 +1,51 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+//// Codegen test source. Never linked, compare_codegen.cmake compiles it to assembly and
+//// requires every unique_<name> function to compile to the same instructions as raw_<name>.
+#include "../../include/memory"
+
+extern "C" {
+    int raw_deref(int* const* p) { return **p; }
+    int unique_deref(const stl::unique_ptr<int>* p) { return **p; }
+
+    void raw_destroy(int* p) { delete p; }
+    void unique_destroy(int* p) { stl::unique_ptr<int> owner{p}; }
+
+    int* raw_release(int** p) {
+        int* released = *p;
+        *p = nullptr;
+        return released;
+    }
+    int* unique_release(stl::unique_ptr<int>* p) { return p->release(); }
+
+    void raw_reset(int** p, int* replacement) {
+        int* old = *p;
+        *p = replacement;
+        delete old;
+    }
+    void unique_reset(stl::unique_ptr<int>* p, int* replacement) { p->reset(replacement); }
+
+    void raw_move_assign(int** dst, int** src) {
+        int* moved = *src;
+        *src = nullptr;
+        int* old = *dst;
+        *dst = moved;
+        delete old;
+    }
+    void unique_move_assign(stl::unique_ptr<int>* dst, stl::unique_ptr<int>* src) { *dst = stl::move(*src); }
+}
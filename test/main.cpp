@@ -17,7 +17,19 @@
  * */
 #include <gtest/gtest.h>
 #include "test_deque.h"
+#include "test_ring_buffer.h"
+#include "test_spsc_queue.h"
 #include "test_vector.h"
+#include "test_small_vector.h"
+#include "test_inplace_vector.h"
+#include "test_pool_allocator.h"
+#include "test_slab_allocator.h"
+#include "test_arena.h"
+#include "test_allocator.h"
+#include "test_memory_resource.h"
+#include "test_shared_ptr.h"
+#include "test_unique_ptr.h"
+#include "test_intrusive_ptr.h"
 
 int main(int argc, char** argv) {
     testing::InitGoogleTest(&argc, argv);
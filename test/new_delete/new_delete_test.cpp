@@ -0,0 +1,134 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+/*
+ * Exercises the operator new/delete routing of src/utillities.cpp against whatever backend the
+ * library it is linked with was built for (malloc, the size-class pools or the sized slabs).
+ * No gtest here: gtest pulls in <new>, and the point is to run on the library's operators alone.
+ * */
+#include "../../src/utillities.h"
+#include <stdio.h>
+
+#ifndef AVRCPP_SIZED_MAX_BYTES
+#define AVRCPP_SIZED_MAX_BYTES 8
+#endif
+
+namespace {
+    int failures = 0;
+    void* volatile sink; // keeps the compiler from eliding new/delete pairs
+
+    void check(bool condition, const char* what) {
+        if(condition)
+            return;
+        printf("FAILED: %s\n", what);
+        failures++;
+    }
+
+    /// Whether the backend hands a freed block of this size straight back out (last in, first out)
+    constexpr auto reuses_blocks_of(size_t size) -> bool {
+#if defined(AVRCPP_USE_POOL_ALLOCATOR)
+        return size <= 32; // the largest pool class
+#elif defined(AVRCPP_USE_SIZED_ALLOCATOR)
+        return size <= AVRCPP_SIZED_MAX_BYTES;
+#else
+        (void)size;
+        return false; // malloc makes no promises
+#endif
+    }
+
+    int destructions = 0;
+    struct base {
+        virtual ~base() { destructions++; }
+    };
+    struct small_derived : base {
+        int v = 1;
+    };
+    struct large_derived : base {
+        char payload[64]{};
+    };
+    struct counted {
+        char v = 0;
+        ~counted() { destructions++; }
+    };
+}
+
+static void delete_through_virtual_base() {
+    destructions = 0;
+    base* b = new small_derived{};
+    sink = b;
+    void* first = b;
+    delete b; // the deleting destructor passes sizeof(small_derived), not sizeof(base)
+    base* again = new small_derived{};
+    sink = again;
+    if(reuses_blocks_of(sizeof(small_derived)))
+        check(again == first, "a block freed through a virtual base is handed out again for the same type");
+    delete again;
+    base* large = new large_derived{};
+    sink = large;
+    delete large;
+    check(destructions == 3, "deleting through a virtual base runs the destructors");
+}
+
+static void unsized_operator_delete() {
+    void* p = ::operator new(4);
+    sink = p;
+    ::operator delete(p); // no size, like a delete of an incomplete type
+    void* q = ::operator new(4);
+    sink = q;
+    if(reuses_blocks_of(4))
+        check(q == p, "a block freed without a size is handed out again");
+    ::operator delete(q, 4);
+    void* large = ::operator new(128);
+    sink = large;
+    ::operator delete(large);
+}
+
+static void array_round_trips() {
+    auto* ints = new int[5]{1, 2, 3, 4, 5};
+    sink = ints;
+    check(ints[4] == 5, "new[] of trivial elements initializes them");
+    delete[] ints; // trivially destructible, so delete[] gets no size
+    destructions = 0;
+    auto* objects = new counted[3];
+    sink = objects;
+    delete[] objects; // the array cookie lets delete[] run every destructor
+    check(destructions == 3, "delete[] destroys every element");
+    auto* bytes = new char[200];
+    sink = bytes;
+    bytes[199] = 1;
+    delete[] bytes;
+}
+
+#ifdef AVRCPP_USE_POOL_ALLOCATOR
+static void pool_fallback() {
+    auto before = stl::pool_fallback_count();
+    delete new small_derived{};
+    check(stl::pool_fallback_count() == before, "small objects are served by the pools");
+    delete new large_derived{};
+    check(stl::pool_fallback_count() == before + 1, "objects larger than the pools fall back to malloc");
+}
+#endif
+
+int main() {
+    delete_through_virtual_base();
+    unsized_operator_delete();
+    array_round_trips();
+#ifdef AVRCPP_USE_POOL_ALLOCATOR
+    pool_fallback();
+#endif
+    return failures == 0 ? 0 : 1;
+}
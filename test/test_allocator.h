@@ -0,0 +1,179 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_ALLOCATOR_H
+#define AVRCPP_TEST_ALLOCATOR_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/memory"
+#include "../include/vector"
+#include "../include/deque"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+namespace {
+    template<typename T>
+    using arena_vector = stl::vector<T, stl::growth::doubling, unsigned int, stl::arena_allocator<T>>;
+    template<typename T>
+    using arena_deque = stl::deque<T, 4, size_t, stl::arena_allocator<T>>;
+
+    struct tracked {
+        static inline int alive = 0;
+        int value;
+        explicit tracked(int v) : value{v} { alive++; }
+        tracked(const tracked& o) : value{o.value} { alive++; }
+        ~tracked() { alive--; }
+    };
+}
+
+TEST(allocator, givenStatelessAllocator_thenContainersAndPointersDoNotGrow) {
+    EXPECT_EQ(sizeof(int*) + 2 * sizeof(unsigned int), sizeof(stl::vector<int>));
+    EXPECT_EQ(sizeof(stl::deque<int>::chunk_cache_type), sizeof(stl::chunk_cache<sizeof(int) * 10>));
+    EXPECT_EQ(sizeof(int*), (sizeof(stl::unique_ptr<int, stl::allocator_delete<stl::allocator<int>>>)));
+    EXPECT_EQ(sizeof(stl::_shared_inplace_block<int, 1, stl::default_ref_count_policy>),
+              (sizeof(stl::_shared_inplace_block<int, 1, stl::default_ref_count_policy, stl::allocator<int>>)));
+}
+
+TEST(allocator, givenArenaVector_whenGrowing_thenStorageComesFromArenaNotHeap) {
+    alignas(8) unsigned char buffer[256];
+    stl::arena a{buffer};
+    test::allocation_counter::reset();
+    {
+        auto sut = arena_vector<int>{stl::arena_allocator<int>{a}};
+        for(int i = 0; i < 10; i++)
+            sut.push_back(i);
+        EXPECT_TRUE(a.owns(sut.get()));
+        EXPECT_EQ(9, sut[9]);
+        auto copy = sut;
+        EXPECT_TRUE(copy.get_allocator() == sut.get_allocator());
+        EXPECT_TRUE(a.owns(copy.get()));
+    }
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_LT(0, a.used());
+}
+
+TEST(allocator, givenArenaAllocator_whenVectorConstructedWithSize_thenStorageComesFromArena) {
+    alignas(8) unsigned char buffer[256];
+    stl::arena a{buffer};
+    auto alloc = stl::arena_allocator<int>{a};
+    test::allocation_counter::reset();
+    {
+        auto reserved = arena_vector<int>(4u, alloc);
+        auto from_int = arena_vector<int>(4, alloc);
+        auto filled = arena_vector<int>(3u, 7, alloc);
+        EXPECT_TRUE(a.owns(reserved.get()));
+        EXPECT_TRUE(a.owns(from_int.get()));
+        EXPECT_TRUE(a.owns(filled.get()));
+        EXPECT_EQ(4, from_int.capacity());
+        EXPECT_EQ(3, filled.size());
+        EXPECT_EQ(7, filled[2]);
+    }
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+}
+
+TEST(allocator, givenVectorsOnDifferentArenas_whenMoveAssigned_thenElementsMovedIntoOwnArena) {
+    alignas(8) unsigned char buffer_a[128], buffer_b[128];
+    stl::arena a{buffer_a}, b{buffer_b};
+    auto sut = arena_vector<int>{stl::arena_allocator<int>{a}};
+    auto other = arena_vector<int>{stl::arena_allocator<int>{b}};
+    other.push_back(1);
+    other.push_back(2);
+    sut = stl::move(other);
+    ASSERT_EQ(2, sut.size());
+    EXPECT_EQ(2, sut[1]);
+    EXPECT_TRUE(a.owns(sut.get()));
+    EXPECT_TRUE(other.empty());
+}
+
+TEST(allocator, givenArenaDeque_whenGrowingBothWays_thenChunksAndMapComeFromArena) {
+    alignas(8) unsigned char buffer[1024];
+    stl::arena a{buffer};
+    test::allocation_counter::reset();
+    {
+        auto sut = arena_deque<int>{stl::arena_allocator<int>{a}};
+        for(int i = 0; i < 20; i++) {
+            sut.push_back(i);
+            sut.push_front(-i);
+        }
+        EXPECT_TRUE(a.owns(&sut.front()));
+        EXPECT_TRUE(a.owns(sut.map));
+        EXPECT_EQ(-19, sut.front());
+        EXPECT_EQ(19, sut.back());
+        auto moved = stl::move(sut);
+        EXPECT_EQ(40, moved.size());
+    }
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+}
+
+TEST(allocator, givenPoolDeque_whenChunksReleased_thenReturnedToPool) {
+    using pool_t = stl::size_class_allocator<stl::fixed_block_pool<16, 8>, stl::fixed_block_pool<64, 4>>;
+    using alloc_t = stl::pool_allocator<int, pool_t>;
+    pool_t pool{};
+    {
+        auto sut = stl::deque<int, 4, size_t, alloc_t>{alloc_t{pool}};
+        for(int i = 0; i < 12; i++)
+            sut.push_back(i);
+        EXPECT_EQ(0, pool.fallback_count());
+    }
+    // Everything went back, so the pool serves the same amount of blocks again without falling back
+    for(int i = 0; i < 8; i++)
+        EXPECT_NE(nullptr, pool.allocate(16));
+    EXPECT_EQ(0, pool.fallback_count());
+}
+
+TEST(allocator, givenAllocateShared_thenObjectAndBlockComeFromArenaAndAreDestroyed) {
+    alignas(8) unsigned char buffer[128];
+    stl::arena a{buffer};
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::allocate_shared<tracked>(stl::arena_allocator<tracked>{a}, 7);
+        auto copy = sut;
+        EXPECT_EQ(7, copy->value);
+        EXPECT_TRUE(a.owns(sut.get()));
+        EXPECT_EQ(1, tracked::alive);
+    }
+    EXPECT_EQ(0, tracked::alive);
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+}
+
+TEST(allocator, givenAllocateUnique_whenDestroyed_thenBlockReturnedToPool) {
+    using pool_t = stl::fixed_block_pool<sizeof(tracked), 1>;
+    pool_t pool{};
+    {
+        auto sut = stl::allocate_unique<tracked>(stl::pool_allocator<tracked, pool_t>{pool}, 3);
+        EXPECT_EQ(3, sut->value);
+        EXPECT_EQ(1, pool.in_use());
+        EXPECT_EQ(sizeof(tracked*) + sizeof(pool_t*), sizeof(sut));
+    }
+    EXPECT_EQ(0, tracked::alive);
+    EXPECT_EQ(0, pool.in_use());
+}
+
+TEST(allocator, givenDefaultAllocator_whenMakeShared_thenSingleHeapAllocation) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::allocate_unique<int>(stl::allocator<int>{}, 5);
+        auto shared = stl::make_shared<int>(6);
+        EXPECT_EQ(11, *sut + *shared);
+        EXPECT_EQ(2, test::allocation_counter::allocations);
+    }
+    EXPECT_EQ(2, test::allocation_counter::deallocations);
+}
+
+#pragma clang diagnostic pop
+#endif
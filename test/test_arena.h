@@ -0,0 +1,88 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_ARENA_H
+#define AVRCPP_TEST_ARENA_H
+#include <gtest/gtest.h>
+#include "../include/memory"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+TEST(arena, givenArena_whenAllocating_thenBlocksAreAlignedAndContiguous) {
+    alignas(8) unsigned char buffer[64];
+    stl::arena sut{buffer};
+    auto* a = static_cast<unsigned char*>(sut.allocate(3, 1));
+    auto* b = static_cast<unsigned char*>(sut.allocate(4, 4));
+    auto* c = static_cast<unsigned char*>(sut.allocate(1, 1));
+    EXPECT_EQ(buffer, a);
+    EXPECT_EQ(buffer + 4, b); // one byte of padding
+    EXPECT_EQ(buffer + 8, c);
+    EXPECT_EQ(9, sut.used());
+    EXPECT_EQ(55, sut.remaining());
+    EXPECT_TRUE(sut.owns(b));
+}
+
+TEST(arena, givenFullArena_whenAllocating_thenNullAndCountedAsFailure) {
+    unsigned char buffer[16];
+    stl::arena sut{buffer};
+    EXPECT_NE(nullptr, sut.allocate(16, 1));
+    EXPECT_EQ(nullptr, sut.allocate(1, 1));
+    EXPECT_EQ(1, sut.allocation_count());
+    EXPECT_EQ(1, sut.failed_allocation_count());
+    EXPECT_EQ(16, sut.used());
+}
+
+TEST(arena, givenScope_whenLeft_thenArenaRewoundButHighWaterKept) {
+    unsigned char buffer[64];
+    stl::arena sut{buffer};
+    auto* outer = sut.allocate(8, 1);
+    for(int i = 0; i < 3; i++) {
+        stl::arena::scope frame{sut};
+        EXPECT_EQ(static_cast<unsigned char*>(outer) + 8, sut.allocate(16, 1));
+        sut.deallocate(outer); // no-op
+        EXPECT_EQ(24, sut.used());
+    }
+    EXPECT_EQ(8, sut.used());
+    EXPECT_EQ(24, sut.high_water());
+    sut.reset();
+    EXPECT_EQ(0, sut.used());
+}
+
+TEST(arena_allocator, givenRebindCopies_whenAllocating_thenAllDrawFromSameArena) {
+    alignas(8) unsigned char buffer[64];
+    stl::arena a{buffer};
+    stl::arena_allocator<char> chars{a};
+    stl::arena_allocator<uint32_t> words{chars};
+    EXPECT_TRUE(chars == words);
+    auto* c = chars.allocate(1);
+    auto* w = words.allocate(2);
+    EXPECT_EQ(buffer, reinterpret_cast<unsigned char*>(c));
+    EXPECT_EQ(buffer + 4, reinterpret_cast<unsigned char*>(w));
+    words.deallocate(w, 2);
+    EXPECT_EQ(12, a.used());
+}
+
+TEST(arena_allocator, givenExhaustedArena_whenAllocating_thenAbort) {
+    unsigned char buffer[4];
+    stl::arena a{buffer};
+    stl::arena_allocator<uint32_t> sut{a};
+    EXPECT_DEATH(sut.allocate(2), "");
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -372,5 +372,484 @@ TEST(deque, givenOneValue_whenPopbackTwice_thenOneDtorCall) {
     EXPECT_TRUE(sut.empty());
 }
 
+TEST(deque, givenSmallSizeType_whenPushBack_thenSizeIsReported) {
+    auto sut = stl::deque<int, 4, uint8_t>{};
+    for(int i = 0; i < 20; i++)
+        sut.push_back(i);
+    EXPECT_EQ(20, sut.size());
+    EXPECT_EQ(19, sut.back());
+    EXPECT_EQ(0, sut.front());
+}
+
+TEST(deque, givenByteSizeTypeAndTinyChunks_whenFilledNearTheLimit_thenMapStaysInBounds) {
+    auto sut = stl::deque<int, 1, uint8_t>{};
+    for(int i = 0; i < 125; i++) {
+        sut.push_back(i);
+        sut.push_front(-i);
+    }
+    EXPECT_EQ(250, sut.size());
+    EXPECT_EQ(-124, sut.front());
+    EXPECT_EQ(124, sut.back());
+    for(int i = 0; i < 125; i++)
+        EXPECT_EQ(i, sut[125 + i]);
+}
+
+TEST(deque, givenByteSizeType_whenPushedPastTheMaximum_thenAborts) {
+    using byte_deque = stl::deque<int, 4, uint8_t>;
+    using byte_deque_of_tiny_chunks = stl::deque<int, 1, uint8_t>;
+    testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_DEATH({
+        auto sut = byte_deque{};
+        for(int i = 0; i < 256; i++)
+            sut.push_back(i); // the 256th element would wrap the count to zero
+    }, "");
+    EXPECT_DEATH({
+        auto sut = byte_deque_of_tiny_chunks{};
+        for(int i = 0; i < 256; i++)
+            sut.push_front(i); // runs out of map slots before the count wraps
+    }, "");
+    auto sut = byte_deque{};
+    for(int i = 0; i < 255; i++)
+        sut.push_back(i);
+    EXPECT_EQ(sut.max_size(), sut.size());
+    EXPECT_EQ(254, sut.back());
+}
+
+// sizeof regressions: narrower size types must actually make the deque smaller
+static_assert(sizeof(stl::deque<int, 10, uint16_t>) < sizeof(stl::deque<int>));
+static_assert(sizeof(stl::deque<int, 10, uint8_t>) < sizeof(stl::deque<int, 10, uint16_t>));
+static_assert(sizeof(stl::deque<int, 10, uint8_t>) < sizeof(stl::deque<int>));
+// A deque using a shared cache only keeps a pointer to it
+static_assert(sizeof(stl::shared_cache_deque<int>) == sizeof(stl::deque<int>)
+              - sizeof(stl::deque<int>::chunk_cache_type) + sizeof(stl::deque<int>::chunk_cache_type*));
+
+TEST(deque, givenSmallChunks_whenPushingBothEnds_thenOrderIsKept) {
+    auto sut = stl::deque<int, 2>{};
+    for(int i = 0; i < 50; i++) {
+        sut.push_back(i);
+        sut.push_front(-i - 1);
+    }
+    ASSERT_EQ(100, sut.size());
+    int expected = -50;
+    for(auto& el : sut)
+        EXPECT_EQ(expected++, el);
+}
+
+TEST(deque, givenManyPushes_whenMapGrows_thenMapIsReallocatedGeometrically) {
+    auto sut = stl::deque<int, 2>{};
+    int map_reallocations = 0;
+    auto* map = sut.map;
+    for(int i = 0; i < 2000; i++) { // 1000 nodes
+        sut.push_back(i);
+        if(sut.map != map) {
+            map_reallocations++;
+            map = sut.map;
+        }
+    }
+    EXPECT_LE(map_reallocations, 10);
+    EXPECT_EQ(1999, sut.back());
+}
+
+TEST(deque, givenOscillationAroundChunkBoundary_whenPushPop_thenMapIsNotReallocated) {
+    auto sut = stl::deque<int, 2>{};
+    sut.push_back(1);
+    auto* map = sut.map;
+    for(int i = 0; i < 100; i++) {
+        sut.push_back(2); // crosses into a new chunk
+        sut.pop_back();   // and back again
+        sut.push_front(0);
+        sut.pop_front();
+    }
+    EXPECT_EQ(map, sut.map);
+    EXPECT_EQ(1, sut.size());
+    EXPECT_EQ(1, sut.front());
+}
+
+TEST(deque, givenValues_whenCopy_thenCopyIsIndependent) {
+    auto a = stl::deque<int, 2>{};
+    for(int i = 0; i < 7; i++)
+        a.push_back(i);
+    auto b = a;
+    b.front() = 42;
+    b.pop_back();
+    EXPECT_EQ(0, a.front());
+    EXPECT_EQ(7, a.size());
+    EXPECT_EQ(42, b.front());
+    EXPECT_EQ(6, b.size());
+    a = b;
+    EXPECT_EQ(42, a.front());
+    EXPECT_EQ(6, a.size());
+}
+
+TEST(deque, givenOscillationAroundChunkBoundary_whenPushPop_thenChunkIsReused) {
+    auto sut = stl::deque<int, 2>{};
+    sut.push_back(1);
+    sut.push_back(2);
+    auto* chunk = sut.map[sut.finish_node];
+    sut.pop_back();
+    EXPECT_EQ(1, sut.get_chunk_cache().size());
+    sut.push_back(2);
+    EXPECT_EQ(chunk, sut.map[sut.finish_node]); // Came back from the cache, not from malloc
+    EXPECT_EQ(0, sut.get_chunk_cache().size());
+}
+
+TEST(deque, givenFilledDeque_whenClearAndRefill_thenSpareChunksAreReused) {
+    auto sut = stl::deque<int, 2>{};
+    sut.get_chunk_cache().set_limit(4);
+    for(int i = 0; i < 8; i++)
+        sut.push_back(i);
+    sut.clear();
+    EXPECT_EQ(4, sut.get_chunk_cache().size()); // The retention limit caps the spare chunks
+    for(int i = 0; i < 8; i++)
+        sut.push_back(i);
+    EXPECT_EQ(0, sut.get_chunk_cache().size());
+    EXPECT_EQ(8, sut.size());
+    EXPECT_EQ(7, sut.back());
+}
+
+TEST(deque, givenSharedCache_whenOneDequeFreesChunks_thenTheOtherReusesThem) {
+    auto cache = stl::shared_cache_deque<int, 2>::chunk_cache_type{8};
+    {
+        auto a = stl::shared_cache_deque<int, 2>{cache};
+        for(int i = 0; i < 10; i++)
+            a.push_back(i);
+    }
+    EXPECT_EQ(6, cache.size()); // The 6 chunks of a
+    auto b = stl::shared_cache_deque<int, 2>{cache};
+    EXPECT_EQ(5, cache.size());
+    b.push_back(1);
+    b.push_back(2);
+    EXPECT_EQ(4, cache.size());
+}
+
+TEST(deque, givenSharedCache_whenShrinkToFit_thenCacheIsLeftForTheOtherDeques) {
+    auto cache = stl::shared_cache_deque<int, 2>::chunk_cache_type{8};
+    auto sut = stl::shared_cache_deque<int, 2>{cache};
+    {
+        auto other = stl::shared_cache_deque<int, 2>{cache};
+        for(int i = 0; i < 10; i++)
+            other.push_back(i);
+        auto copy = other;
+        EXPECT_EQ(&cache, &copy.get_chunk_cache());
+    }
+    auto spare = cache.size();
+    EXPECT_LT(0, spare);
+    sut.shrink_to_fit();
+    EXPECT_EQ(spare, cache.size());
+}
+
+TEST(deque, givenSpareChunks_whenShrinkToFit_thenCacheIsEmptiedAndMapShrinks) {
+    auto sut = stl::deque<int, 2>{};
+    sut.get_chunk_cache().set_limit(8);
+    for(int i = 0; i < 40; i++)
+        sut.push_back(i);
+    for(int i = 0; i < 36; i++)
+        sut.pop_front();
+    EXPECT_LT(0, sut.get_chunk_cache().size());
+    sut.shrink_to_fit();
+    EXPECT_EQ(0, sut.get_chunk_cache().size());
+    EXPECT_EQ(5, sut.map_size); // 3 nodes in use, and a spare slot at either end
+    int i = 36;
+    for(auto& el : sut)
+        EXPECT_EQ(i++, el);
+    sut.push_front(35);
+    sut.push_back(40);
+    EXPECT_EQ(35, sut.front());
+    EXPECT_EQ(40, sut.back());
+}
+
+static_assert(stl::deque_chunk_elements<uint8_t, 64>::value == 64);
+static_assert(stl::deque_chunk_elements<uint32_t, 64>::value == 16);
+static_assert(stl::deque_chunk_elements<uint8_t[12], 64>::value == 4);         // 5 rounded down to a power of two
+static_assert(stl::deque_chunk_elements<uint8_t[12], 64, false>::value == 5);
+static_assert(stl::deque_chunk_elements<uint8_t[100], 64>::value == 1);        // always at least one element
+static_assert(stl::budget_deque<uint16_t, 32>::iterator::chunk_is_power_of_two);
+static_assert(!stl::deque<int, 10>::iterator::chunk_is_power_of_two);
+
+TEST(deque, givenPowerOfTwoChunks_whenRandomAccess_thenCorrectElementsAreFound) {
+    auto sut = stl::budget_deque<int, 4 * sizeof(int)>{}; // 4 elements per chunk
+    for(int i = 0; i < 30; i++)
+        sut.push_back(i);
+    for(int i = 0; i < 30; i++)
+        EXPECT_EQ(i, sut.begin()[i]);
+    auto last = sut.begin() + 29;
+    for(int i = 0; i < 30; i++)
+        EXPECT_EQ(29 - i, *(last - i));
+    EXPECT_EQ(30, sut.end() - sut.begin());
+}
+
+TEST(deque, givenNonPowerOfTwoBudget_whenRandomAccess_thenCorrectElementsAreFound) {
+    auto sut = stl::budget_deque<int, 5 * sizeof(int), false>{}; // 5 elements per chunk
+    for(int i = 0; i < 30; i++)
+        sut.push_front(i);
+    auto last = sut.begin() + 29;
+    for(int i = 0; i < 30; i++) {
+        EXPECT_EQ(29 - i, sut.begin()[i]);
+        EXPECT_EQ(i, *(last - i));
+    }
+}
+
+TEST(deque, givenValues_whenIteratingCompact_thenSameAsRegularIteration) {
+    auto sut = stl::deque<int, 3, uint8_t>{};
+    for(int i = 0; i < 10; i++) {
+        sut.push_back(i);
+        sut.push_front(-i - 1);
+    }
+    EXPECT_EQ(20, sut.compact_end() - sut.compact_begin());
+    auto it = sut.begin();
+    for(auto c = sut.compact_begin(); c != sut.compact_end(); ++c, ++it)
+        EXPECT_EQ(*it, *c);
+    EXPECT_EQ(sut.end(), it);
+    EXPECT_EQ(9, *(sut.compact_begin() + 19));
+    EXPECT_EQ(-10, *(sut.compact_end() - 20));
+    EXPECT_EQ(5, sut.compact_begin()[15]);
+}
+
+TEST(deque, givenValues_whenPushAndPop_thenSizeIsTracked) {
+    auto sut = stl::deque<int, 2>{};
+    for(int i = 0; i < 9; i++)
+        sut.push_back(i);
+    sut.pop_front();
+    sut.pop_back();
+    sut.push_front(42);
+    EXPECT_EQ(8, sut.size());
+    EXPECT_EQ(sut.size(), static_cast<size_t>(sut.end() - sut.begin()));
+    EXPECT_EQ(42, sut.front());
+    EXPECT_EQ(7, sut.back());
+    sut.clear();
+    EXPECT_EQ(0, sut.size());
+}
+
+TEST(deque, givenValues_whenMoveConstruct_thenNoElementIsCopiedOrMoved) {
+    static int cpyctor_counter = 0;
+    static int mvctor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(const test_struct& o) : v{o.v} { cpyctor_counter++; }
+        test_struct(test_struct&& o) noexcept : v{o.v} { mvctor_counter++; }
+    };
+    auto a = stl::deque<test_struct, 2>{};
+    for(int i = 0; i < 7; i++)
+        a.emplace_back(i);
+    auto b = stl::move(a);
+    EXPECT_EQ(0, cpyctor_counter);
+    EXPECT_EQ(0, mvctor_counter);
+    EXPECT_EQ(7, b.size());
+    EXPECT_EQ(6, b.back().v);
+    EXPECT_TRUE(a.empty());
+    EXPECT_EQ(a.begin(), a.end());
+    a.emplace_back(42); // A moved-from deque can be reused
+    EXPECT_EQ(42, a.front().v);
+    EXPECT_EQ(1, a.size());
+}
+
+TEST(deque, givenValues_whenMoveAssign_thenResourcesAreHandedOver) {
+    static int dtor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        ~test_struct() { dtor_counter++; }
+    };
+    auto a = stl::deque<test_struct>{};
+    a.emplace_back(1);
+    a.emplace_back(2);
+    auto b = stl::deque<test_struct>{};
+    b.emplace_back(3);
+    b = stl::move(a);
+    EXPECT_EQ(1, dtor_counter); // only b's old element
+    EXPECT_EQ(2, b.size());
+    EXPECT_EQ(1, b.front().v);
+    EXPECT_TRUE(a.empty());
+}
+
+TEST(deque, givenRvalues_whenPushBackAndFront_thenElementsAreMovedNotCopied) {
+    static int cpyctor_counter = 0;
+    static int mvctor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(const test_struct& o) : v{o.v} { cpyctor_counter++; }
+        test_struct(test_struct&& o) noexcept : v{o.v} { mvctor_counter++; }
+    };
+    auto sut = stl::deque<test_struct>{};
+    sut.push_back(test_struct{1});
+    sut.push_front(test_struct{2});
+    auto lvalue = test_struct{3};
+    sut.push_back(stl::move(lvalue));
+    EXPECT_EQ(0, cpyctor_counter);
+    EXPECT_EQ(3, mvctor_counter);
+    sut.push_back(lvalue);
+    EXPECT_EQ(1, cpyctor_counter);
+}
+
+TEST(deque, givenForwardedArguments_whenEmplace_thenArgumentsAreNotCopied) {
+    static int cpyctor_counter = 0;
+    static int mvctor_counter = 0;
+    struct argument {
+        argument() = default;
+        argument(const argument&) { cpyctor_counter++; }
+        argument(argument&&) noexcept { mvctor_counter++; }
+    };
+    struct test_struct {
+        test_struct(const argument&, int& out) { out++; }
+    };
+    auto sut = stl::deque<test_struct>{};
+    auto arg = argument{};
+    int constructed = 0;
+    sut.emplace_back(arg, constructed); // if the int was copied, the counter would stay at 0
+    sut.emplace_front(arg, constructed);
+    EXPECT_EQ(2, constructed);
+    EXPECT_EQ(0, cpyctor_counter);
+    EXPECT_EQ(0, mvctor_counter);
+}
+
+TEST(deque, givenValues_whenIndexing_thenCorrectElementsAreReturned) {
+    auto sut = stl::deque<int, 3>{};
+    for(int i = 0; i < 10; i++) {
+        sut.push_back(i);
+        sut.push_front(-i - 1);
+    }
+    for(int i = 0; i < 20; i++) {
+        EXPECT_EQ(i - 10, sut[i]);
+        EXPECT_EQ(i - 10, sut.at(i));
+    }
+    sut[5] = 42;
+    EXPECT_EQ(42, sut.begin()[5]);
+}
+
+TEST(deque, givenValues_whenInsertNearFront_thenOnlyFrontIsShifted) {
+    static int mvassign_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(test_struct&& o) noexcept : v{o.v} {}
+        auto operator=(test_struct&& o) noexcept -> test_struct& { v = o.v; mvassign_counter++; return *this; }
+    };
+    auto sut = stl::deque<test_struct, 4>{};
+    for(int i = 0; i < 20; i++)
+        sut.emplace_back(i < 3 ? i : i + 1);
+    auto it = sut.emplace(sut.begin() + 3, 3);
+    EXPECT_EQ(3, it->v);
+    EXPECT_EQ(21, sut.size());
+    for(int i = 0; i < 21; i++)
+        EXPECT_EQ(i, sut[i].v);
+    EXPECT_EQ(3, mvassign_counter); // the two shifted elements and the new one. The other 17 stay put
+}
+
+TEST(deque, givenValues_whenInsertNearBack_thenOnlyBackIsShifted) {
+    auto sut = stl::deque<int, 4>{};
+    for(int i = 0; i < 20; i++)
+        if(i != 17)
+            sut.push_back(i);
+    auto it = sut.insert(sut.begin() + 17, 17);
+    EXPECT_EQ(17, *it);
+    EXPECT_EQ(20, sut.size());
+    for(int i = 0; i < 20; i++)
+        EXPECT_EQ(i, sut[i]);
+    sut.insert(sut.end(), 20);
+    sut.insert(sut.begin(), -1);
+    EXPECT_EQ(-1, sut.front());
+    EXPECT_EQ(20, sut.back());
+}
+
+TEST(deque, givenValues_whenErase_thenGapIsClosedFromTheShorterSide) {
+    static int dtor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        ~test_struct() { dtor_counter++; }
+    };
+    auto sut = stl::deque<test_struct, 4>{};
+    for(int i = 0; i < 20; i++)
+        sut.emplace_back(i);
+    auto it = sut.erase(sut.begin() + 2);
+    EXPECT_EQ(3, it->v);
+    sut.erase_index(16); // the element 17
+    EXPECT_EQ(2, dtor_counter);
+    EXPECT_EQ(18, sut.size());
+    int expected[] = {0, 1, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 18, 19};
+    for(int i = 0; i < 18; i++)
+        EXPECT_EQ(expected[i], sut[i].v);
+}
+
+TEST(deque, givenSlidingWindow_whenPushAndPop_thenWindowIsIndexable) {
+    auto sut = stl::deque<int, 4, uint8_t>{};
+    for(int i = 0; i < 100; i++) {
+        sut.push_back(i);
+        if(sut.size() > 8)
+            sut.pop_front();
+        for(int j = 0; j < sut.size(); j++)
+            EXPECT_EQ(i - sut.size() + 1 + j, sut[j]);
+    }
+}
+
+TEST(deque, givenUnalignedRange_whenForEachSegment_thenOneContiguousBlockPerChunk) {
+    auto sut = stl::deque<int, 4>{};
+    for(int i = 0; i < 14; i++)
+        sut.push_back(i);
+    sut.push_front(-1);
+    int blocks = 0;
+    int expected = -1;
+    stl::for_each_segment(sut.begin(), sut.end(), [&](int* first, int* last) {
+        blocks++;
+        EXPECT_LE(last - first, 4);
+        for(; first != last; ++first)
+            EXPECT_EQ(expected++, *first);
+    });
+    EXPECT_EQ(14, expected);
+    EXPECT_EQ(5, blocks); // 1 + 4 + 4 + 4 + 2
+    blocks = 0;
+    stl::for_each_segment(sut.compact_begin() + 2, sut.compact_end() - 1, [&](int*, int*) { blocks++; });
+    EXPECT_EQ(4, blocks);
+}
+
+TEST(deque, givenElements_whenSegmentedAlgorithms_thenSameAsElementWise) {
+    auto sut = stl::deque<int, 4>{};
+    for(int i = 0; i < 21; i++)
+        sut.push_back(i);
+    sut.pop_front();
+    EXPECT_EQ(210, stl::accumulate(sut.begin(), sut.end(), 0));
+    EXPECT_EQ(210 - 1 - 20, stl::accumulate(sut.compact_begin() + 1, sut.compact_end() - 1, 0));
+    EXPECT_EQ(13, *stl::find(sut.begin(), sut.end(), 13));
+    EXPECT_EQ(sut.end(), stl::find(sut.begin(), sut.end(), 0));
+    EXPECT_EQ(sut.begin() + 12, stl::find(sut.begin() + 3, sut.end(), 13));
+    int count = 0;
+    stl::for_each(sut.begin(), sut.end(), [&count](int& v) { v *= 2; count++; });
+    EXPECT_EQ(20, count);
+    EXPECT_EQ(40, sut.back());
+    stl::fill(sut.begin() + 1, sut.end() - 1, 7);
+    EXPECT_EQ(2, sut.front());
+    EXPECT_EQ(7, sut[1]);
+    EXPECT_EQ(7, sut[18]);
+    EXPECT_EQ(40, sut[19]);
+}
+
+TEST(deque, givenBytes_whenFillAndCopyBetweenDeques_thenChunksAreMemcopied) {
+    auto a = stl::deque<uint8_t, 8>{};
+    auto b = stl::deque<uint8_t, 16>{}; // different chunk boundaries on both sides
+    for(int i = 0; i < 50; i++) {
+        a.push_back(static_cast<uint8_t>(i));
+        b.push_back(0);
+    }
+    b.push_front(0);
+    stl::copy(a.begin() + 5, a.end(), b.begin() + 1);
+    EXPECT_EQ(0, b[0]);
+    for(int i = 1; i < 46; i++)
+        EXPECT_EQ(i + 4, b[i]);
+    EXPECT_EQ(0, b[46]);
+    uint8_t raw[50] = {};
+    EXPECT_EQ(raw + 50, stl::copy(a.begin(), a.end(), raw));
+    EXPECT_EQ(49, raw[49]);
+    stl::fill(a.begin() + 3, a.end(), 0xAB);
+    EXPECT_EQ(2, a[2]);
+    EXPECT_EQ(0xAB, a[3]);
+    EXPECT_EQ(0xAB, a[49]);
+    stl::copy(raw, raw + 10, a.begin() + 2);
+    EXPECT_EQ(0, a[2]);
+    EXPECT_EQ(9, a[11]);
+    EXPECT_EQ(0xAB, a[12]);
+}
+
 #pragma clang diagnostic pop
 #endif
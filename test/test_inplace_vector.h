@@ -0,0 +1,116 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_INPLACE_VECTOR_H
+#define AVRCPP_TEST_INPLACE_VECTOR_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/inplace_vector"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+static_assert(sizeof(stl::inplace_vector<uint8_t, 10>) == 10 + sizeof(uint8_t));
+static_assert(sizeof(stl::inplace_vector<uint8_t, 255>) == 255 + sizeof(uint8_t));
+static_assert(sizeof(stl::inplace_vector<uint8_t, 300>) == 300 + sizeof(uint16_t));
+static_assert(sizeof(stl::inplace_vector<uint16_t, 7>) == 14 + 2);
+// A char buffer with a wider counter is padded to the counter's alignment
+static_assert(sizeof(stl::inplace_vector<char, 257>) == stl::inplace_vector<char, 257>::footprint);
+static_assert(sizeof(stl::inplace_vector<char, 301>) == 301 + 1 + sizeof(uint16_t));
+static_assert(stl::is_same<stl::inplace_vector<int, 200>::size_type, uint8_t>::value);
+static_assert(stl::is_same<stl::inplace_vector<int, 256>::size_type, uint16_t>::value);
+static_assert(stl::is_same<stl::inplace_vector<char, 70000>::size_type, uint32_t>::value);
+
+TEST(inplace_vector, givenCharBufferWithWiderCounter_whenFilled_thenFootprintHoldsAndElementsKept) {
+    stl::inplace_vector<char, 301> sut{};
+    static_assert(sizeof(sut.size()) == sizeof(uint16_t));
+    for(int i = 0; i < 301; i++)
+        sut.push_back(static_cast<char>('a' + i % 26));
+    EXPECT_TRUE(sut.full());
+    EXPECT_EQ('a' + 300 % 26, sut.back());
+}
+
+TEST(inplace_vector, givenBlank_whenPushBack_thenNoAllocation) {
+    test::allocation_counter::reset();
+    auto sut = stl::inplace_vector<int, 4>();
+    sut.push_back(1);
+    sut.emplace_back(2);
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(2, sut.size());
+    EXPECT_EQ(1, sut[0]);
+    EXPECT_EQ(2, sut.back());
+}
+
+TEST(inplace_vector, givenFull_whenTryPushBack_thenRejected) {
+    auto sut = stl::inplace_vector<int, 2>();
+    EXPECT_TRUE(sut.try_push_back(1));
+    EXPECT_TRUE(sut.try_push_back(2));
+    EXPECT_TRUE(sut.full());
+    EXPECT_FALSE(sut.try_push_back(3));
+    EXPECT_FALSE(sut.try_emplace_back(3));
+    EXPECT_EQ(2, sut.size());
+    EXPECT_EQ(2, sut.back());
+}
+
+TEST(inplace_vector, givenElements_whenInsertAndErase_thenOrderIsKept) {
+    auto sut = stl::inplace_vector<int, 4>();
+    sut.push_back(1);
+    sut.push_back(3);
+    sut.insert(sut.begin() + 1, 2);
+    int i = 1;
+    for(auto& el : sut)
+        EXPECT_EQ(i++, el);
+    sut.erase(sut.begin());
+    EXPECT_EQ(2, sut.front());
+    EXPECT_EQ(2, sut.size());
+    sut.push_back(4);
+    sut.push_back(5);
+    EXPECT_FALSE(sut.try_insert(sut.begin(), 0));
+}
+
+TEST(inplace_vector, givenClassElements_whenClearAndDestroy_thenDtorsAreCalled) {
+    static int dtor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        ~test_struct() { dtor_counter++; }
+    };
+    {
+        auto sut = stl::inplace_vector<test_struct, 3>();
+        sut.emplace_back(1);
+        sut.emplace_back(2);
+        sut.clear();
+        EXPECT_EQ(2, dtor_counter);
+        sut.emplace_back(3);
+    }
+    EXPECT_EQ(3, dtor_counter);
+}
+
+TEST(inplace_vector, givenElements_whenCopyAndMove_thenElementsFollow) {
+    auto a = stl::inplace_vector<int, 4>();
+    a.push_back(1);
+    a.push_back(2);
+    auto b = a;
+    EXPECT_EQ(2, b.size());
+    auto c = stl::move(a);
+    EXPECT_EQ(2, c.size());
+    EXPECT_EQ(0, a.size());
+    EXPECT_EQ(2, c[1]);
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,121 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_INTRUSIVE_PTR_H
+#define AVRCPP_TEST_INTRUSIVE_PTR_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/memory"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+namespace {
+    struct intrusive_message : stl::intrusive_ref_counter<intrusive_message> {
+        static inline int destructions = 0;
+        int payload;
+        explicit intrusive_message(int payload) : payload{payload} { }
+        ~intrusive_message() { destructions++; }
+    };
+
+    // Pooled objects hook the customization points themselves
+    struct pooled_message {
+        uint8_t refs = 0;
+        bool returned = false;
+    };
+    void intrusive_add_ref(pooled_message* p) { p->refs++; }
+    void intrusive_release(pooled_message* p) {
+        if(--p->refs == 0)
+            p->returned = true;
+    }
+}
+
+TEST(intrusive_ptr, givenIntrusivePtr_thenSizeOfSinglePointer) {
+    EXPECT_EQ(sizeof(intrusive_message*), sizeof(stl::intrusive_ptr<intrusive_message>));
+    EXPECT_LE(sizeof(intrusive_message), sizeof(int) + alignof(int)); // the counter lives in the object
+}
+
+TEST(intrusive_ptr, givenCopies_whenLastReleased_thenDeletedWithoutExtraAllocations) {
+    intrusive_message::destructions = 0;
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::intrusive_ptr<intrusive_message>{new intrusive_message{3}};
+        EXPECT_EQ(1, sut->use_count());
+        {
+            auto copy = sut;
+            auto other = stl::intrusive_ptr<intrusive_message>{};
+            other = copy;
+            EXPECT_EQ(3, sut->use_count());
+            EXPECT_EQ(3, other->payload);
+            EXPECT_TRUE(other == sut);
+        }
+        EXPECT_EQ(1, sut->use_count());
+        EXPECT_EQ(0, intrusive_message::destructions);
+    }
+    EXPECT_EQ(1, intrusive_message::destructions);
+    EXPECT_EQ(1, test::allocation_counter::allocations);
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+TEST(intrusive_ptr, givenMove_whenMoved_thenCountUnchangedAndSourceEmpty) {
+    auto sut = stl::intrusive_ptr<intrusive_message>{new intrusive_message{1}};
+    auto moved = stl::move(sut);
+    EXPECT_FALSE(sut);
+    EXPECT_EQ(1, moved->use_count());
+    sut = stl::move(moved);
+    EXPECT_TRUE(sut);
+    EXPECT_FALSE(moved);
+}
+
+TEST(intrusive_ptr, givenCustomHooks_whenLastReleased_thenReturnedToPool) {
+    pooled_message pool[2];
+    {
+        auto a = stl::intrusive_ptr<pooled_message>{&pool[0]};
+        auto b = a;
+        EXPECT_EQ(2, pool[0].refs);
+        b.reset(&pool[1]);
+        EXPECT_EQ(1, pool[0].refs);
+        EXPECT_EQ(1, pool[1].refs);
+    }
+    EXPECT_TRUE(pool[0].returned);
+    EXPECT_TRUE(pool[1].returned);
+}
+
+TEST(intrusive_ptr, givenDetach_whenAdoptedAgain_thenReferenceIsKept) {
+    pooled_message msg{};
+    auto sut = stl::intrusive_ptr<pooled_message>{&msg};
+    auto* raw = sut.detach();
+    EXPECT_EQ(1, msg.refs);
+    {
+        auto adopted = stl::intrusive_ptr<pooled_message>{raw, false};
+        EXPECT_EQ(1, msg.refs);
+    }
+    EXPECT_TRUE(msg.returned);
+}
+
+TEST(intrusive_ptr, givenByteCounter_whenCopiedPastTheMaximum_thenAbortsInDebugMode) {
+    testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_DEATH({
+        auto sut = stl::intrusive_ptr<intrusive_message>{new intrusive_message{1}};
+        stl::intrusive_ptr<intrusive_message> copies[255];
+        for(auto& copy : copies)
+            copy = sut; // the 255th copy would wrap the count to zero
+    }, "");
+}
+
+#pragma clang diagnostic pop
+#endif
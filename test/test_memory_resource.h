@@ -0,0 +1,142 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_MEMORY_RESOURCE_H
+#define AVRCPP_TEST_MEMORY_RESOURCE_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/memory_resource"
+#include "../include/vector"
+#include "../include/deque"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+namespace {
+    /// Upstream resource that counts what goes through it
+    class counting_resource : public stl::pmr::memory_resource {
+    public:
+        counting_resource() : memory_resource{&do_allocate, &do_deallocate} {}
+        size_t allocations = 0;
+        size_t deallocations = 0;
+        size_t live_bytes = 0;
+    private:
+        static auto do_allocate(memory_resource* r, size_t bytes, size_t alignment) -> void* {
+            auto* self = static_cast<counting_resource*>(r);
+            self->allocations++;
+            self->live_bytes += bytes;
+            return stl::pmr::new_delete_resource()->allocate(bytes, alignment);
+        }
+        static void do_deallocate(memory_resource* r, void* p, size_t bytes, size_t alignment) {
+            auto* self = static_cast<counting_resource*>(r);
+            self->deallocations++;
+            self->live_bytes -= bytes;
+            stl::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+        }
+    };
+}
+
+TEST(memory_resource, givenNewDeleteResource_thenGoesThroughGlobalHeap) {
+    auto* sut = stl::pmr::new_delete_resource();
+    EXPECT_EQ(sut, stl::pmr::get_default_resource());
+    test::allocation_counter::reset();
+    auto* p = sut->allocate(12);
+    sut->deallocate(p, 12);
+    EXPECT_EQ(1, test::allocation_counter::allocations);
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+TEST(memory_resource, givenMonotonicResource_whenBufferExhausted_thenUpstreamBlocksGrowAndAreReleased) {
+    counting_resource upstream{};
+    alignas(8) unsigned char buffer[16];
+    {
+        stl::pmr::monotonic_buffer_resource sut{buffer, sizeof(buffer), &upstream};
+        auto* a = static_cast<unsigned char*>(sut.allocate(6, 2));
+        auto* b = static_cast<unsigned char*>(sut.allocate(8, 4));
+        EXPECT_EQ(buffer, a);
+        EXPECT_EQ(buffer + 8, b);
+        EXPECT_EQ(0, upstream.allocations);
+        auto* c = sut.allocate(40, 8);
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(c) % 8);
+        sut.deallocate(c, 40, 8); // no-op
+        sut.allocate(4, 1);        // still fits in the upstream block
+        EXPECT_EQ(1, upstream.allocations);
+        sut.allocate(200, 1);
+        EXPECT_EQ(2, upstream.allocations);
+        sut.release();
+        EXPECT_EQ(2, upstream.deallocations);
+        EXPECT_EQ(buffer, sut.allocate(1, 1)); // starts over in the initial buffer
+    }
+    EXPECT_EQ(0, upstream.live_bytes);
+}
+
+TEST(memory_resource, givenPoolResource_whenBlocksFreed_thenReusedWithoutGoingUpstream) {
+    counting_resource upstream{};
+    {
+        stl::pmr::unsynchronized_pool_resource sut{stl::pmr::pool_options{4, 32}, &upstream};
+        EXPECT_EQ(32, sut.largest_pool_block());
+        auto* a = sut.allocate(10, 2);
+        auto* b = sut.allocate(12, 4);
+        EXPECT_EQ(2, upstream.allocations); // chunks start at one block and double
+        sut.deallocate(a, 10, 2);
+        EXPECT_EQ(a, sut.allocate(9, 1));
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(b) % 4);
+        auto* big = sut.allocate(100, 8); // larger than any pool
+        EXPECT_EQ(3, upstream.allocations);
+        sut.deallocate(big, 100, 8);
+        EXPECT_EQ(1, upstream.deallocations);
+        for(int i = 0; i < 8; i++)
+            sut.allocate(16, 8);
+        EXPECT_EQ(5, upstream.allocations); // the 16 byte pool asked for 2 and then 4 (the cap) blocks
+    }
+    EXPECT_EQ(0, upstream.live_bytes);
+}
+
+TEST(memory_resource, givenPmrVectors_whenOnDifferentResources_thenSameTypeAndElementsFollowAssignment) {
+    alignas(8) unsigned char buffer[256];
+    stl::pmr::monotonic_buffer_resource arena{buffer, sizeof(buffer), stl::pmr::new_delete_resource()};
+    stl::pmr::unsynchronized_pool_resource pool{};
+    stl::pmr::vector<int> on_arena{&arena};
+    stl::pmr::vector<int> on_pool{&pool};
+    for(int i = 0; i < 10; i++)
+        on_arena.push_back(i);
+    on_pool = stl::move(on_arena);
+    ASSERT_EQ(10, on_pool.size());
+    EXPECT_EQ(9, on_pool[9]);
+    EXPECT_EQ(&pool, on_pool.get_allocator().resource());
+    EXPECT_FALSE(on_pool.get_allocator() == on_arena.get_allocator());
+}
+
+TEST(memory_resource, givenPmrDeque_whenDefaultResourceChanged_thenDrawsFromIt) {
+    counting_resource upstream{};
+    stl::pmr::unsynchronized_pool_resource pool{&upstream};
+    auto* previous = stl::pmr::set_default_resource(&pool);
+    {
+        test::allocation_counter::reset();
+        stl::pmr::deque<int, 4> sut{};
+        for(int i = 0; i < 10; i++)
+            sut.push_front(i);
+        EXPECT_EQ(9, sut.front());
+        EXPECT_LT(0, upstream.allocations);
+        EXPECT_EQ(upstream.allocations, test::allocation_counter::allocations); // nothing bypasses the pool
+    }
+    stl::pmr::set_default_resource(previous);
+    EXPECT_EQ(stl::pmr::new_delete_resource(), stl::pmr::get_default_resource());
+}
+
+#pragma clang diagnostic pop
+#endif
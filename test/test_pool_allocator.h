@@ -0,0 +1,85 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_POOL_ALLOCATOR_H
+#define AVRCPP_TEST_POOL_ALLOCATOR_H
+#include <gtest/gtest.h>
+#include "../include/stl/pool_allocator.h"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+// Global pools must be ready before any static constructor calls operator new
+namespace {
+    constinit stl::fixed_block_pool<8, 4> constant_initialized_pool{};
+    constinit stl::size_class_allocator<stl::fixed_block_pool<4, 2>, stl::fixed_block_pool<16, 2>> constant_initialized_classes{};
+}
+
+TEST(fixed_block_pool, givenPool_whenExhausted_thenNullAndFreedBlocksReusedLastInFirstOut) {
+    auto sut = stl::fixed_block_pool<8, 4>{};
+    void* blocks[4];
+    for(auto& b : blocks) {
+        b = sut.allocate();
+        ASSERT_NE(nullptr, b);
+        EXPECT_TRUE(sut.owns(b));
+    }
+    EXPECT_EQ(nullptr, sut.allocate());
+    EXPECT_EQ(0, sut.available());
+    sut.deallocate(blocks[1]);
+    sut.deallocate(blocks[3]);
+    EXPECT_EQ(blocks[3], sut.allocate());
+    EXPECT_EQ(blocks[1], sut.allocate());
+    EXPECT_EQ(4, sut.in_use());
+}
+
+TEST(fixed_block_pool, givenPool_thenBlocksAreDistinctAlignedAndWithoutHeaders) {
+    auto sut = stl::fixed_block_pool<16, 3>{};
+    auto* a = static_cast<unsigned char*>(sut.allocate());
+    auto* b = static_cast<unsigned char*>(sut.allocate());
+    EXPECT_EQ(16, b - a);
+    EXPECT_EQ(0, reinterpret_cast<uintptr_t>(a) % (stl::fixed_block_pool<16, 3>::alignment));
+    EXPECT_EQ(1, (sizeof(stl::fixed_block_pool<16, 3>::index_type)));
+    EXPECT_EQ(48 + 3, (sizeof(stl::fixed_block_pool<1, 48>))); // 48 one byte blocks + 3 one byte indices
+    int outside = 0;
+    EXPECT_FALSE(sut.owns(&outside));
+}
+
+TEST(size_class_allocator, givenRequests_whenServed_thenSmallestFittingClassThenSpillThenMalloc) {
+    using small = stl::fixed_block_pool<4, 2>;
+    using large = stl::fixed_block_pool<16, 1>;
+    auto sut = stl::size_class_allocator<small, large>{};
+    auto* a = sut.allocate(3);
+    auto* b = sut.allocate(4);
+    auto* c = sut.allocate(2);  // small is exhausted, spills into large
+    auto* d = sut.allocate(1);  // everything exhausted
+    auto* e = sut.allocate(64); // too big for any class
+    EXPECT_EQ(2, sut.fallback_count());
+    for(auto* p : {a, b, c, d, e})
+        ASSERT_NE(nullptr, p);
+    memset(e, 0xAA, 64);
+    sut.deallocate(d);
+    sut.deallocate(e);
+    sut.deallocate(c);
+    sut.deallocate(nullptr);
+    EXPECT_EQ(c, sut.allocate(10));
+    EXPECT_EQ(2, sut.fallback_count());
+    sut.deallocate(a);
+    sut.deallocate(b);
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,172 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_RING_BUFFER_H
+#define AVRCPP_TEST_RING_BUFFER_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/ring_buffer"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+TEST(ring_buffer, givenBlank_whenPushBackAndPopFront_thenFifoOrder) {
+    test::allocation_counter::reset();
+    auto sut = stl::ring_buffer<int, 4>{};
+    for(int round = 0; round < 5; round++) { // wraps around several times
+        EXPECT_TRUE(sut.push_back(round * 10 + 1));
+        EXPECT_TRUE(sut.push_back(round * 10 + 2));
+        EXPECT_TRUE(sut.push_back(round * 10 + 3));
+        EXPECT_EQ(round * 10 + 1, sut.front());
+        EXPECT_TRUE(sut.pop_front());
+        EXPECT_TRUE(sut.pop_front());
+        EXPECT_EQ(round * 10 + 3, sut.front());
+        EXPECT_TRUE(sut.pop_front());
+        EXPECT_TRUE(sut.empty());
+    }
+    EXPECT_FALSE(sut.pop_front());
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+}
+
+TEST(ring_buffer, givenRejectPolicy_whenFull_thenPushIsRejected) {
+    auto sut = stl::ring_buffer<int, 3>{};
+    EXPECT_TRUE(sut.push_back(1));
+    EXPECT_TRUE(sut.push_back(2));
+    EXPECT_TRUE(sut.push_front(0));
+    EXPECT_TRUE(sut.full());
+    EXPECT_FALSE(sut.push_back(3));
+    EXPECT_FALSE(sut.push_front(-1));
+    for(int i = 0; i < 3; i++)
+        EXPECT_EQ(i, sut[i]);
+}
+
+TEST(ring_buffer, givenOverwritePolicy_whenFull_thenOldestIsDropped) {
+    auto sut = stl::ring_buffer<int, 3, stl::ring_policy::overwrite>{};
+    for(int i = 0; i < 5; i++)
+        EXPECT_TRUE(sut.push_back(i));
+    EXPECT_EQ(3, sut.size());
+    EXPECT_EQ(2, sut.front());
+    EXPECT_EQ(4, sut.back());
+    sut.push_front(42); // drops the back
+    EXPECT_EQ(42, sut[0]);
+    EXPECT_EQ(2, sut[1]);
+    EXPECT_EQ(3, sut[2]);
+}
+
+TEST(ring_buffer, givenFullOverwriteBuffer_whenPushingOwnElement_thenItIsCopiedBeforeEviction) {
+    static const void* last_destroyed = nullptr;
+    static int copies_of_destroyed = 0;
+    struct test_struct {
+        int v = 0;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(const test_struct& o) : v{o.v} {
+            if(&o == last_destroyed)
+                copies_of_destroyed++;
+        }
+        ~test_struct() { last_destroyed = this; }
+    };
+    auto sut = stl::ring_buffer<test_struct, 3, stl::ring_policy::overwrite>{};
+    for(int i = 0; i < 3; i++)
+        sut.emplace_back(i);
+    sut.push_back(sut.front()); // evicts the very element it copies
+    EXPECT_EQ(0, copies_of_destroyed);
+    EXPECT_EQ(1, sut[0].v);
+    EXPECT_EQ(0, sut[2].v);
+    sut.push_front(sut.back()); // likewise from the other end
+    EXPECT_EQ(0, copies_of_destroyed);
+    EXPECT_EQ(0, sut[0].v);
+    EXPECT_EQ(1, sut[1].v);
+    EXPECT_EQ(2, sut[2].v);
+}
+
+TEST(ring_buffer, givenValues_whenPushFrontAndPopBack_thenLifoFromTheFront) {
+    auto sut = stl::ring_buffer<int, 5>{};
+    sut.push_front(1);
+    sut.push_front(2);
+    sut.push_back(0);
+    EXPECT_EQ(2, sut.front());
+    EXPECT_EQ(0, sut.back());
+    EXPECT_TRUE(sut.pop_back());
+    EXPECT_EQ(1, sut.back());
+    int expected = 2;
+    for(auto& el : sut)
+        EXPECT_EQ(expected--, el);
+}
+
+TEST(ring_buffer, givenWrappedBuffer_whenPushNAndPopN_thenSegmentsAreCopiedInOrder) {
+    auto sut = stl::ring_buffer<uint8_t, 8>{};
+    uint8_t in[6] = {1, 2, 3, 4, 5, 6};
+    EXPECT_EQ(6, sut.push_n(in, 6));
+    uint8_t out[8] = {};
+    EXPECT_EQ(5, sut.pop_n(out, 5));
+    EXPECT_EQ(5, out[4]);
+    EXPECT_EQ(6, sut.push_n(in, 6)); // wraps
+    EXPECT_EQ(7, sut.size());
+    EXPECT_EQ(1, sut.push_n(in, 6)); // only one slot left
+    EXPECT_EQ(8, sut.pop_n(out, 10));
+    uint8_t expected[8] = {6, 1, 2, 3, 4, 5, 6, 1};
+    for(int i = 0; i < 8; i++)
+        EXPECT_EQ(expected[i], out[i]);
+    EXPECT_TRUE(sut.empty());
+}
+
+TEST(ring_buffer, givenOverwritePolicy_whenPushNTooMany_thenNewestSurvive) {
+    auto sut = stl::ring_buffer<int, 4, stl::ring_policy::overwrite>{};
+    int in[6] = {1, 2, 3, 4, 5, 6};
+    sut.push_back(0);
+    EXPECT_EQ(6, sut.push_n(in, 6));
+    EXPECT_EQ(4, sut.size());
+    for(int i = 0; i < 4; i++)
+        EXPECT_EQ(i + 3, sut[i]);
+}
+
+TEST(ring_buffer, givenClassElements_whenPopN_thenElementsAreMovedAndDestroyed) {
+    static int dtor_counter = 0;
+    struct test_struct {
+        int v = 0;
+        test_struct() = default;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(const test_struct& o) = default;
+        auto operator=(const test_struct& o) -> test_struct& = default;
+        ~test_struct() { dtor_counter++; }
+    };
+    {
+        auto sut = stl::ring_buffer<test_struct, 3>{};
+        sut.emplace_back(1);
+        sut.emplace_back(2);
+        test_struct out[2];
+        EXPECT_EQ(2, sut.pop_n(out, 2));
+        EXPECT_EQ(2, dtor_counter);
+        EXPECT_EQ(2, out[1].v);
+        sut.emplace_back(3);
+    }
+    EXPECT_EQ(5, dtor_counter); // the out array and the last element
+}
+
+TEST(ring_buffer, givenNonPowerOfTwoCapacity_whenWrapping_thenIndexingIsCorrect) {
+    auto sut = stl::ring_buffer<int, 5>{};
+    for(int i = 0; i < 23; i++) {
+        if(sut.full())
+            sut.pop_front();
+        sut.push_back(i);
+    }
+    for(int i = 0; i < 5; i++)
+        EXPECT_EQ(18 + i, sut.at(i));
+}
+
+#pragma clang diagnostic pop
+#endif
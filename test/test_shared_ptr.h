@@ -0,0 +1,340 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_SHARED_PTR_H
+#define AVRCPP_TEST_SHARED_PTR_H
+#include <gtest/gtest.h>
+#include <thread>
+#include "allocation_counter.h"
+#include "../include/memory"
+#include "../include/vector"
+#include "../include/deque"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+TEST(shared_ptr, givenMakeShared_whenCreated_thenObjectAndCounterShareOneAllocation) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::make_shared<int>(42);
+        EXPECT_EQ(42, *sut);
+        EXPECT_EQ(1, sut.use_count());
+        EXPECT_EQ(1, test::allocation_counter::allocations);
+        EXPECT_EQ(sizeof(stl::_shared_inplace_block<int, 1, stl::default_ref_count_policy>), test::allocation_counter::bytes_allocated);
+    }
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+TEST(shared_ptr, givenMakeSharedArray_whenCreated_thenElementsAndCounterShareOneAllocation) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::make_shared_array<int>(1, 2, 3);
+        EXPECT_EQ(1, sut[0]);
+        EXPECT_EQ(3, sut[2]);
+        EXPECT_EQ(1, test::allocation_counter::allocations);
+        EXPECT_EQ(sizeof(stl::_shared_inplace_block<int, 3, stl::default_ref_count_policy>), test::allocation_counter::bytes_allocated);
+    }
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+TEST(shared_ptr, givenRawPointer_whenAdopted_thenSeparateControlBlockAndBothReleased) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::shared_ptr<int>{new int(7)};
+        EXPECT_EQ(2, test::allocation_counter::allocations);
+        auto copy = sut;
+        EXPECT_EQ(2, sut.use_count());
+        EXPECT_EQ(2, test::allocation_counter::allocations);
+    }
+    EXPECT_EQ(2, test::allocation_counter::deallocations);
+}
+
+TEST(shared_ptr, givenEmpty_whenConstructed_thenNoAllocation) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::shared_ptr<int>{};
+        auto from_null = stl::shared_ptr<int>{nullptr};
+        EXPECT_EQ(0, sut.use_count());
+        EXPECT_EQ(nullptr, from_null.get());
+        sut = stl::make_shared<int>(1);
+        sut = from_null;
+        EXPECT_EQ(0, sut.use_count());
+    }
+    EXPECT_EQ(1, test::allocation_counter::allocations);
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+namespace {
+    struct shared_base {
+        int base_value = 1;
+    };
+    struct shared_derived : shared_base {
+        static inline int destructions = 0;
+        int derived_value;
+        explicit shared_derived(int v) : derived_value{v} { }
+        ~shared_derived() { destructions++; }
+    };
+}
+
+TEST(shared_ptr, givenDerived_whenLastBasePointerReleased_thenDerivedDestructorRuns) {
+    shared_derived::destructions = 0;
+    test::allocation_counter::reset();
+    {
+        stl::shared_ptr<shared_base> base{};
+        {
+            auto derived = stl::make_shared<shared_derived>(5);
+            base = derived;
+            EXPECT_EQ(2, base.use_count());
+        }
+        EXPECT_EQ(0, shared_derived::destructions);
+        EXPECT_EQ(1, base->base_value);
+    }
+    EXPECT_EQ(1, shared_derived::destructions);
+    EXPECT_EQ(test::allocation_counter::allocations, test::allocation_counter::deallocations);
+}
+
+TEST(shared_ptr, givenManyObjects_whenMadeShared_thenHeapBytesPerObjectBelowTwoBlocks) {
+    constexpr int n = 16;
+    test::allocation_counter::reset();
+    {
+        stl::shared_ptr<int> objects[n];
+        for(int i = 0; i < n; i++)
+            objects[i] = stl::make_shared<int>(i);
+        EXPECT_EQ(n, test::allocation_counter::allocations);
+        // Adopting would cost the int plus a separate block with a pointer to it
+        auto adopted_bytes = sizeof(int) + sizeof(stl::_shared_pointer_block<int, stl::default_deleter<int>, stl::default_ref_count_policy>);
+        EXPECT_LT(test::allocation_counter::bytes_allocated / n, adopted_bytes);
+    }
+    EXPECT_EQ(n, test::allocation_counter::deallocations);
+}
+
+TEST(weak_ptr, givenWeakPtr_whenLockedWhileAlive_thenSharesOwnership) {
+    auto owner = stl::make_shared<int>(5);
+    stl::weak_ptr<int> sut = owner;
+    EXPECT_FALSE(sut.expired());
+    EXPECT_EQ(1, sut.use_count());
+    {
+        auto locked = sut.lock();
+        EXPECT_EQ(5, *locked);
+        EXPECT_EQ(2, owner.use_count());
+    }
+    EXPECT_EQ(1, owner.use_count());
+}
+
+TEST(weak_ptr, givenMadeShared_whenLastOwnerGone_thenObjectDestroyedButBlockKeptUntilLastWeak) {
+    shared_derived::destructions = 0;
+    test::allocation_counter::reset();
+    stl::weak_ptr<shared_base> sut{};
+    {
+        auto owner = stl::make_shared<shared_derived>(3);
+        sut = owner;
+        auto another = sut;
+        EXPECT_EQ(1, test::allocation_counter::allocations);
+    }
+    EXPECT_EQ(1, shared_derived::destructions);
+    EXPECT_TRUE(sut.expired());
+    EXPECT_EQ(nullptr, sut.lock().get());
+    EXPECT_EQ(0, test::allocation_counter::deallocations); // the block is still observed
+    sut.reset();
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+    EXPECT_EQ(1, shared_derived::destructions);
+}
+
+TEST(weak_ptr, givenAdoptedPointer_whenLastOwnerGone_thenObjectFreedBeforeBlock) {
+    test::allocation_counter::reset();
+    {
+        stl::weak_ptr<int> sut{};
+        {
+            auto owner = stl::shared_ptr<int>{new int(1)};
+            sut = owner;
+        }
+        EXPECT_TRUE(sut.expired());
+        EXPECT_EQ(1, test::allocation_counter::deallocations); // just the int
+    }
+    EXPECT_EQ(2, test::allocation_counter::deallocations);
+}
+
+TEST(weak_ptr, givenCache_whenEntriesExpire_thenEntriesCanBeRefreshed) {
+    stl::weak_ptr<int> cache[2];
+    auto first = stl::make_shared<int>(10);
+    cache[0] = first;
+    {
+        auto temporary = stl::make_shared<int>(20);
+        cache[1] = temporary;
+    }
+    EXPECT_FALSE(cache[0].expired());
+    EXPECT_TRUE(cache[1].expired());
+    auto refreshed = stl::make_shared<int>(21);
+    cache[1] = refreshed;
+    EXPECT_EQ(21, *cache[1].lock());
+    auto moved = stl::move(cache[0]);
+    EXPECT_TRUE(cache[0].expired());
+    EXPECT_EQ(10, *moved.lock());
+}
+
+TEST(shared_ptr, givenWideCounterPolicy_whenCopiedMoreThan255Times_thenCountDoesNotWrap) {
+    using policy = stl::ref_count::plain<uint16_t>;
+    auto sut = stl::make_shared<int, policy>(1);
+    {
+        stl::shared_ptr<int, stl::default_deleter<int>, policy> copies[300];
+        for(auto& copy : copies)
+            copy = sut;
+        EXPECT_EQ(301, sut.use_count());
+    }
+    EXPECT_EQ(1, sut.use_count());
+    EXPECT_EQ(1, *sut);
+}
+
+TEST(shared_ptr, givenByteCounter_whenCopiedPastTheMaximum_thenAbortsInDebugMode) {
+    testing::FLAGS_gtest_death_test_style = "threadsafe";
+    EXPECT_DEATH({
+        auto sut = stl::make_shared<int>(1);
+        stl::shared_ptr<int> copies[255];
+        for(auto& copy : copies)
+            copy = sut; // the 255th copy would wrap the count to zero
+    }, "");
+}
+
+TEST(shared_ptr, givenInterruptMaskedPolicy_whenCopiedAndLocked_thenCountsAsUsual) {
+    using policy = stl::ref_count::interrupt_masked<uint8_t>;
+    stl::weak_ptr<int, policy> observer{};
+    {
+        auto sut = stl::make_shared<int, policy>(4);
+        observer = sut;
+        auto copy = sut;
+        EXPECT_EQ(2, observer.use_count());
+        EXPECT_EQ(4, *observer.lock());
+    }
+    EXPECT_TRUE(observer.expired());
+}
+
+TEST(shared_ptr, givenAtomicPolicy_whenCopiedFromTwoThreads_thenObjectDestroyedExactlyOnce) {
+    using policy = stl::ref_count::atomic<uint32_t>;
+    shared_derived::destructions = 0;
+    {
+        auto sut = stl::make_shared<shared_derived, policy>(1);
+        stl::weak_ptr<shared_derived, policy> observer = sut;
+        auto churn = [&sut, &observer]() {
+            for(int i = 0; i < 100000; i++) {
+                auto copy = sut;
+                auto locked = observer.lock();
+                EXPECT_TRUE(locked.get() != nullptr);
+            }
+        };
+        std::thread other(churn);
+        churn();
+        other.join();
+        EXPECT_EQ(1, sut.use_count());
+        EXPECT_EQ(0, shared_derived::destructions);
+    }
+    EXPECT_EQ(1, shared_derived::destructions);
+}
+
+namespace {
+    // Counts every counter modification, so tests can verify which operations avoid them
+    struct counting_policy {
+        using counter_type = uint8_t;
+        static inline int touches = 0;
+        static void increment(counter_type& c) { touches++; ++c; }
+        static auto decrement(counter_type& c) -> bool { touches++; return --c == 0; }
+        static auto increment_if_nonzero(counter_type& c) -> bool { touches++; return c != 0 && ++c; }
+        static auto load(const counter_type& c) -> counter_type { return c; }
+    };
+    using counted_ptr = stl::shared_ptr<int, stl::default_deleter<int>, counting_policy>;
+}
+
+TEST(shared_ptr, givenSharedPtr_whenMoveConstructed_thenSourceEmptyAndCounterUntouched) {
+    auto source = stl::make_shared<int, counting_policy>(3);
+    counting_policy::touches = 0;
+    counted_ptr sut{stl::move(source)};
+    EXPECT_EQ(0, counting_policy::touches);
+    EXPECT_EQ(nullptr, source.get());
+    EXPECT_EQ(0, source.use_count());
+    EXPECT_EQ(1, sut.use_count());
+    EXPECT_EQ(3, *sut);
+}
+
+TEST(shared_ptr, givenTwoObjects_whenMoveAssigned_thenOldTargetReleased) {
+    test::allocation_counter::reset();
+    {
+        auto a = stl::make_shared<int>(1);
+        auto b = stl::make_shared<int>(2);
+        a = stl::move(b);
+        EXPECT_EQ(1, test::allocation_counter::deallocations);
+        EXPECT_EQ(2, *a);
+        EXPECT_EQ(nullptr, b.get());
+        auto& alias = a;
+        a = stl::move(alias); // self move keeps the object alive
+        EXPECT_EQ(2, *a);
+        EXPECT_EQ(1, a.use_count());
+    }
+    EXPECT_EQ(2, test::allocation_counter::deallocations);
+}
+
+TEST(shared_ptr, givenDerived_whenMovedIntoBase_thenOwnershipTransferred) {
+    shared_derived::destructions = 0;
+    {
+        auto derived = stl::make_shared<shared_derived>(9);
+        stl::shared_ptr<shared_base> base{stl::move(derived)};
+        EXPECT_EQ(nullptr, derived.get());
+        EXPECT_EQ(1, base.use_count());
+        stl::shared_ptr<shared_base> other{};
+        other = stl::make_shared<shared_derived>(10);
+        EXPECT_EQ(1, other.use_count());
+    }
+    EXPECT_EQ(2, shared_derived::destructions);
+}
+
+TEST(shared_ptr, givenSharedPtrs_whenResetAndSwapped_thenOwnershipFollows) {
+    test::allocation_counter::reset();
+    {
+        auto a = stl::make_shared<int>(1);
+        auto b = stl::make_shared<int>(2);
+        a.swap(b);
+        EXPECT_EQ(2, *a);
+        EXPECT_EQ(1, *b);
+        b.reset();
+        EXPECT_EQ(nullptr, b.get());
+        EXPECT_EQ(1, test::allocation_counter::deallocations);
+        a.reset(new int(5));
+        EXPECT_EQ(5, *a);
+        EXPECT_EQ(2, test::allocation_counter::deallocations);
+    }
+    EXPECT_EQ(test::allocation_counter::allocations, test::allocation_counter::deallocations);
+}
+
+TEST(shared_ptr, givenSharedPtrs_whenMovedThroughVectorAndDeque_thenCounterUntouched) {
+    auto queue = stl::deque<counted_ptr, 4>{};
+    for(int i = 0; i < 20; i++)
+        queue.push_back(stl::make_shared<int, counting_policy>(i));
+    counting_policy::touches = 0;
+    auto list = stl::vector<counted_ptr>{};
+    while(!queue.empty()) { // the vector reallocates a few times on the way
+        list.push_back(stl::move(queue.front()));
+        queue.pop_front();
+    }
+    for(int i = 0; i < 20; i++)
+        queue.push_front(stl::move(list[i]));
+    list.clear(); // only moved-from husks left, nothing to release
+    EXPECT_EQ(0, counting_policy::touches);
+    EXPECT_EQ(20, queue.size());
+    EXPECT_EQ(19, *queue.front());
+    EXPECT_EQ(1, queue.front().use_count());
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,58 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_SLAB_ALLOCATOR_H
+#define AVRCPP_TEST_SLAB_ALLOCATOR_H
+#include <gtest/gtest.h>
+#include "../include/stl/slab_allocator.h"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+TEST(slab_allocator, givenSmallRequests_whenAllocated_thenPackedWithoutHeaders) {
+    constexpr auto granule = sizeof(void*);
+    auto sut = stl::slab_allocator<2 * sizeof(void*), 4>{};
+    auto* a = static_cast<unsigned char*>(sut.allocate(1));
+    auto* b = static_cast<unsigned char*>(sut.allocate(granule));
+    auto* c = static_cast<unsigned char*>(sut.allocate(granule + 1)); // next class, own slab
+    EXPECT_EQ(granule, b - a);
+    EXPECT_EQ(2, sut.slab_count());
+    EXPECT_EQ(granule, sut.block_size_of(b));
+    EXPECT_EQ(2 * granule, sut.block_size_of(c));
+    int outside = 0;
+    EXPECT_EQ(0, sut.block_size_of(&outside));
+    EXPECT_EQ(nullptr, sut.allocate(2 * granule + 1));
+    sut.release();
+}
+
+TEST(slab_allocator, givenSizedDeallocation_whenAllocatingAgain_thenBlockReusedAndSlabsOnlyGrowWhenFull) {
+    auto sut = stl::slab_allocator<8, 4>{};
+    void* blocks[4];
+    for(auto& b : blocks)
+        b = sut.allocate(2);
+    EXPECT_EQ(1, sut.slab_count());
+    sut.deallocate(blocks[2], 2);
+    EXPECT_EQ(blocks[2], sut.allocate(1)); // any size of the same class
+    EXPECT_EQ(1, sut.slab_count());
+    sut.allocate(2);
+    EXPECT_EQ(2, sut.slab_count());
+    sut.release();
+    EXPECT_EQ(0, sut.slab_count());
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,180 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_SMALL_VECTOR_H
+#define AVRCPP_TEST_SMALL_VECTOR_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/small_vector"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+TEST(small_vector, givenBlank_whenConstruct_thenNoAllocation) {
+    test::allocation_counter::reset();
+    auto sut = stl::small_vector<int, 4>();
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(0, sut.size());
+    EXPECT_EQ(4, sut.capacity());
+    EXPECT_TRUE(sut.is_inline());
+}
+
+TEST(small_vector, givenInlineCapacity_whenPushBackUpToN_thenNoAllocation) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::small_vector<int, 4>();
+        for(int i = 0; i < 4; i++)
+            sut.push_back(i);
+        EXPECT_TRUE(sut.is_inline());
+        for(int i = 0; i < 4; i++)
+            EXPECT_EQ(i, sut[i]);
+    }
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(0, test::allocation_counter::deallocations);
+}
+
+TEST(small_vector, givenFullInlineBuffer_whenPushBack_thenSpillToHeap) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::small_vector<int, 4>();
+        for(int i = 0; i < 5; i++)
+            sut.push_back(i);
+        EXPECT_FALSE(sut.is_inline());
+        EXPECT_EQ(1, test::allocation_counter::allocations);
+        EXPECT_EQ(8, sut.capacity());
+        for(int i = 0; i < 5; i++)
+            EXPECT_EQ(i, sut[i]);
+    }
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+TEST(small_vector, givenInlineElements_whenMove_thenElementsAreMovedAndNoAllocation) {
+    static int mvctor_counter = 0;
+    static int cpyctor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(const test_struct& o) : v{o.v} { cpyctor_counter++; }
+        test_struct(test_struct&& o) noexcept : v{o.v} { mvctor_counter++; }
+    };
+    test::allocation_counter::reset();
+    auto a = stl::small_vector<test_struct, 4>();
+    a.emplace_back(1);
+    a.emplace_back(2);
+    auto b = stl::move(a);
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(0, cpyctor_counter);
+    EXPECT_EQ(2, mvctor_counter);
+    EXPECT_EQ(2, b.size());
+    EXPECT_EQ(0, a.size());
+    EXPECT_EQ(2, b[1].v);
+}
+
+TEST(small_vector, givenHeapElements_whenMove_thenBufferIsStolen) {
+    auto a = stl::small_vector<int, 2>();
+    for(int i = 0; i < 5; i++)
+        a.push_back(i);
+    test::allocation_counter::reset();
+    auto b = stl::move(a);
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(5, b.size());
+    EXPECT_TRUE(a.is_inline());
+    EXPECT_EQ(0, a.size());
+    EXPECT_EQ(4, b[4]);
+}
+
+TEST(small_vector, givenElements_whenCopy_thenElementsAreCopied) {
+    auto a = stl::small_vector<int, 2>();
+    for(int i = 0; i < 3; i++)
+        a.push_back(i);
+    auto b = a;
+    EXPECT_EQ(3, b.size());
+    b[0] = 42;
+    EXPECT_EQ(0, a[0]);
+    EXPECT_EQ(42, b[0]);
+}
+
+TEST(small_vector, givenElements_whenInsertAndErase_thenOrderIsKept) {
+    auto sut = stl::small_vector<int, 4>();
+    sut.push_back(1);
+    sut.push_back(3);
+    sut.insert(sut.begin() + 1, 2);
+    sut.erase(sut.begin());
+    auto it = sut.begin();
+    EXPECT_EQ(2, *(it++));
+    EXPECT_EQ(3, *(it++));
+    EXPECT_EQ(sut.end(), it);
+}
+
+TEST(small_vector, givenHeapElements_whenClear_thenBackToInline) {
+    auto sut = stl::small_vector<int, 2>();
+    for(int i = 0; i < 5; i++)
+        sut.push_back(i);
+    sut.clear();
+    EXPECT_TRUE(sut.is_inline());
+    EXPECT_EQ(2, sut.capacity());
+    EXPECT_TRUE(sut.empty());
+}
+
+TEST(small_vector, givenFixedStepGrowth_whenSpillToHeap_thenCapacityGrowsByStep) {
+    auto sut = stl::small_vector<int, 2, stl::growth::fixed_step<3>>();
+    for(int i = 0; i < 6; i++)
+        sut.push_back(i);
+    EXPECT_EQ(8, sut.capacity());
+    for(int i = 0; i < 6; i++)
+        EXPECT_EQ(i, sut[i]);
+}
+
+TEST(small_vector, givenNarrowSizeType_whenConstruct_thenCountersShrink) {
+    static_assert(sizeof(stl::small_vector<char, 4, stl::growth::doubling, uint8_t>) < sizeof(stl::small_vector<char, 4>));
+    auto sut = stl::small_vector<int, 4, stl::growth::doubling, uint8_t>();
+    for(int i = 0; i < 200; i++)
+        sut.push_back(i);
+    EXPECT_EQ(200, sut.size());
+    EXPECT_EQ(199, sut.back());
+}
+
+TEST(small_vector, givenHeapElementsThatFitInline_whenShrinkToFit_thenBackToInline) {
+    auto sut = stl::small_vector<int, 4>();
+    for(int i = 0; i < 6; i++)
+        sut.push_back(i);
+    sut.pop_back();
+    sut.pop_back();
+    test::allocation_counter::reset();
+    sut.shrink_to_fit();
+    EXPECT_TRUE(sut.is_inline());
+    EXPECT_EQ(4, sut.capacity());
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+    for(int i = 0; i < 4; i++)
+        EXPECT_EQ(i, sut[i]);
+}
+
+TEST(small_vector, givenSpareHeapCapacity_whenShrinkToFit_thenCapacityIsSize) {
+    auto sut = stl::small_vector<int, 2>();
+    for(int i = 0; i < 5; i++)
+        sut.push_back(i);
+    EXPECT_EQ(8, sut.capacity());
+    sut.shrink_to_fit();
+    EXPECT_FALSE(sut.is_inline());
+    EXPECT_EQ(5, sut.capacity());
+    for(int i = 0; i < 5; i++)
+        EXPECT_EQ(i, sut[i]);
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,136 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_SPSC_QUEUE_H
+#define AVRCPP_TEST_SPSC_QUEUE_H
+#include <gtest/gtest.h>
+#include <thread>
+#include "allocation_counter.h"
+#include "../include/spsc_queue"
+#include "../include/vector"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+TEST(spsc_queue, givenBlank_whenPushAndPop_thenFifoOrderAcrossWrapAround) {
+    test::allocation_counter::reset();
+    auto sut = stl::spsc_queue<int, 4>{};
+    int out = 0;
+    for(int round = 0; round < 10; round++) {
+        EXPECT_TRUE(sut.push(round * 10 + 1));
+        EXPECT_TRUE(sut.push(round * 10 + 2));
+        EXPECT_TRUE(sut.push(round * 10 + 3));
+        EXPECT_EQ(3, sut.size());
+        EXPECT_TRUE(sut.pop(out));
+        EXPECT_EQ(round * 10 + 1, out);
+        EXPECT_TRUE(sut.pop(out));
+        EXPECT_TRUE(sut.pop(out));
+        EXPECT_EQ(round * 10 + 3, out);
+        EXPECT_TRUE(sut.empty());
+        EXPECT_FALSE(sut.pop(out));
+    }
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+}
+
+TEST(spsc_queue, givenFull_whenPush_thenRejectedAndAllSlotsUsable) {
+    auto sut = stl::spsc_queue<uint8_t, 8>{};
+    for(uint8_t i = 0; i < 8; i++)
+        EXPECT_TRUE(sut.push(i));
+    EXPECT_TRUE(sut.full());
+    EXPECT_FALSE(sut.push(42));
+    uint8_t out = 0;
+    EXPECT_TRUE(sut.pop(out));
+    EXPECT_EQ(0, out);
+    EXPECT_TRUE(sut.push(42));
+}
+
+TEST(spsc_queue, givenIndexType_thenNarrowestThatHoldsTwiceTheCapacity) {
+    EXPECT_EQ(1, sizeof(stl::spsc_queue<uint8_t, 128>::index_type));
+    EXPECT_EQ(2, sizeof(stl::spsc_queue<uint8_t, 256>::index_type));
+    EXPECT_EQ(16 + 2, sizeof(stl::spsc_queue<uint8_t, 16>));
+}
+
+TEST(spsc_queue, givenElements_whenPushNAndPopNAcrossTheEnd_thenSplitIntoSegments) {
+    auto sut = stl::spsc_queue<int, 8>{};
+    int out[8] = {};
+    int in[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    EXPECT_EQ(5, sut.push_n(in, 5));
+    EXPECT_EQ(5, sut.pop_n(out, 5));
+    EXPECT_EQ(8, sut.push_n(in, 8)); // starts at slot 5 and wraps
+    EXPECT_EQ(0, sut.push_n(in, 1));
+    EXPECT_EQ(8, sut.pop_n(out, 10));
+    for(int i = 0; i < 8; i++)
+        EXPECT_EQ(i + 1, out[i]);
+    EXPECT_EQ(0, sut.pop_n(out, 1));
+}
+
+TEST(spsc_queue, givenNonTrivialElements_whenDestroyed_thenRemainingElementsReleased) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::spsc_queue<stl::vector<int>, 4>{};
+        auto v = stl::vector<int>{};
+        v.push_back(1);
+        sut.push(v);
+        sut.push(v);
+        auto out = stl::vector<int>{};
+        EXPECT_TRUE(sut.pop(out));
+        EXPECT_EQ(1, out[0]);
+    }
+    EXPECT_EQ(test::allocation_counter::allocations, test::allocation_counter::deallocations);
+}
+
+TEST(spsc_queue, givenTwoThreads_whenStreamingElements_thenReceivedInOrder) {
+    auto sut = stl::spsc_queue<uint32_t, 64>{};
+    constexpr uint32_t total = 200000;
+    std::thread producer([&sut]() {
+        for(uint32_t i = 0; i < total;) {
+            if(i % 3 == 0) { // mix single and batched pushes
+                uint32_t batch[7];
+                for(uint32_t j = 0; j < 7; j++)
+                    batch[j] = i + j;
+                auto n = static_cast<uint32_t>(sut.push_n(batch, stl::min<size_t>(7, total - i)));
+                if(n == 0)
+                    std::this_thread::yield(); // the test host may only have a single core
+                i += n;
+            } else if(sut.push(i)) {
+                i++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    uint32_t expected = 0;
+    bool in_order = true;
+    uint32_t buf[5];
+    while(expected < total) {
+        auto n = sut.pop_n(buf, 5);
+        for(size_t j = 0; j < n; j++)
+            in_order &= buf[j] == expected++;
+        uint32_t single;
+        if(sut.pop(single))
+            in_order &= single == expected++;
+        else if(n == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(total, expected);
+    EXPECT_TRUE(sut.empty());
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -0,0 +1,145 @@
+/*
+ * This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ *
+ * original author: sillydan1 <https://github.com/sillydan1>
+ * */
+#ifndef AVRCPP_TEST_UNIQUE_PTR_H
+#define AVRCPP_TEST_UNIQUE_PTR_H
+#include <gtest/gtest.h>
+#include "allocation_counter.h"
+#include "../include/memory"
+// Suppress clangd-tidy complains about static storage in gtest
+#pragma clang diagnostic push
+#pragma ide diagnostic ignored "cert-err58-cpp"
+
+namespace {
+    struct unique_base {
+        virtual ~unique_base() = default;
+        int value = 0;
+    };
+    struct unique_derived : unique_base {
+        static inline int destructions = 0;
+        ~unique_derived() override { destructions++; }
+    };
+
+    // Stateful deleter, e.g. a handle to the pool the object came from
+    struct pool_deleter {
+        int* returned;
+        void free(int* p) { (*returned)++; delete p; }
+    };
+
+    int function_deleter_calls = 0;
+    void function_deleter(int* p) {
+        function_deleter_calls++;
+        delete p;
+    }
+}
+
+TEST(unique_ptr, givenStatelessDeleter_thenSizeOfRawPointer) {
+    static_assert(sizeof(stl::unique_ptr<int>) == sizeof(int*));
+    static_assert(sizeof(stl::unique_ptr<int[]>) == sizeof(int*));
+    static_assert(sizeof(stl::unique_ptr<int, pool_deleter>) == sizeof(int*) + sizeof(int*));
+    static_assert(sizeof(stl::unique_ptr<int, void(*)(int*)>) == sizeof(int*) + sizeof(void(*)(int*)));
+    SUCCEED();
+}
+
+TEST(unique_ptr, givenDefaultConstructed_thenEmptyAndNoAllocation) {
+    test::allocation_counter::reset();
+    {
+        stl::unique_ptr<int> sut{};
+        stl::unique_ptr<int> from_null{nullptr};
+        EXPECT_FALSE(sut);
+        EXPECT_EQ(nullptr, from_null.get());
+    }
+    EXPECT_EQ(0, test::allocation_counter::allocations);
+    EXPECT_EQ(0, test::allocation_counter::deallocations);
+}
+
+TEST(unique_ptr, givenUniquePtr_whenMoved_thenOwnershipTransferredExactlyOnce) {
+    test::allocation_counter::reset();
+    {
+        auto source = stl::make_unique<int>(4);
+        stl::unique_ptr<int> sut{stl::move(source)};
+        EXPECT_FALSE(source);
+        EXPECT_EQ(4, *sut);
+        auto other = stl::make_unique<int>(5);
+        sut = stl::move(other);
+        EXPECT_EQ(1, test::allocation_counter::deallocations);
+        EXPECT_EQ(5, *sut);
+        auto& alias = sut;
+        sut = stl::move(alias);
+        EXPECT_EQ(5, *sut);
+    }
+    EXPECT_EQ(2, test::allocation_counter::deallocations);
+}
+
+TEST(unique_ptr, givenDerived_whenMovedIntoBase_thenSourceReleasedAndDerivedDestroyedOnce) {
+    unique_derived::destructions = 0;
+    {
+        auto derived = stl::make_unique<unique_derived>();
+        stl::unique_ptr<unique_base> base{stl::move(derived)};
+        EXPECT_EQ(nullptr, derived.get());
+        stl::unique_ptr<unique_base> other{};
+        other = stl::make_unique<unique_derived>();
+    }
+    EXPECT_EQ(2, unique_derived::destructions);
+}
+
+TEST(unique_ptr, givenUniquePtr_whenReleaseResetAndSwap_thenOwnershipFollows) {
+    test::allocation_counter::reset();
+    auto a = stl::make_unique<int>(1);
+    auto b = stl::make_unique<int>(2);
+    a.swap(b);
+    EXPECT_EQ(2, *a);
+    EXPECT_EQ(1, *b);
+    int* raw = b.release();
+    EXPECT_FALSE(b);
+    b.reset(raw);
+    EXPECT_EQ(0, test::allocation_counter::deallocations);
+    b.reset();
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+    a = nullptr;
+    EXPECT_EQ(2, test::allocation_counter::deallocations);
+}
+
+TEST(unique_ptr, givenStatefulAndFunctionDeleters_whenDestroyed_thenStoredDeleterUsed) {
+    int returned = 0;
+    function_deleter_calls = 0;
+    {
+        stl::unique_ptr<int, pool_deleter> a{new int(1), pool_deleter{&returned}};
+        stl::unique_ptr<int, pool_deleter> moved{stl::move(a)};
+        EXPECT_EQ(&returned, moved.get_deleter().returned);
+        stl::unique_ptr<int, void(*)(int*)> b{new int(2), &function_deleter};
+        b.reset(new int(3));
+        EXPECT_EQ(1, function_deleter_calls);
+    }
+    EXPECT_EQ(1, returned);
+    EXPECT_EQ(2, function_deleter_calls);
+}
+
+TEST(unique_ptr, givenArray_whenMadeUnique_thenValueInitializedAndDeletedAsArray) {
+    test::allocation_counter::reset();
+    {
+        auto sut = stl::make_unique<int[]>(4);
+        EXPECT_EQ(0, sut[3]);
+        sut[3] = 7;
+        EXPECT_EQ(7, sut[3]);
+    }
+    EXPECT_EQ(1, test::allocation_counter::allocations);
+    EXPECT_EQ(1, test::allocation_counter::deallocations);
+}
+
+#pragma clang diagnostic pop
+#endif
@@ -89,5 +89,117 @@ TEST(vector, givenElements_whenErasingEnd_thenLastElementIsRemoved) {
     EXPECT_EQ(sut.end(), it);
 }
 
+TEST(vector, givenClass_whenReserve_thenNoDefaultConstruction) {
+    static int ctor_counter = 0;
+    struct test_struct {
+        test_struct() { ctor_counter++; }
+    };
+    auto sut = stl::vector<test_struct>();
+    sut.reserve(100);
+    EXPECT_EQ(0, ctor_counter);
+    EXPECT_EQ(100, sut.capacity());
+    EXPECT_EQ(0, sut.size());
+}
+
+TEST(vector, givenClassElements_whenGrowing_thenElementsAreMovedNotCopied) {
+    static int cpyctor_counter = 0;
+    static int mvctor_counter = 0;
+    static int dtor_counter = 0;
+    struct test_struct {
+        int v;
+        explicit test_struct(int v) : v{v} {}
+        test_struct(const test_struct& o) : v{o.v} { cpyctor_counter++; }
+        test_struct(test_struct&& o) noexcept : v{o.v} { mvctor_counter++; }
+        ~test_struct() { dtor_counter++; }
+    };
+    {
+        auto sut = stl::vector<test_struct>();
+        for(int i = 0; i < 8; i++)
+            sut.emplace_back(i);
+        EXPECT_EQ(0, cpyctor_counter);
+        EXPECT_EQ(1 + 2 + 4, mvctor_counter); // relocations when growing 1 -> 2 -> 4 -> 8
+        EXPECT_EQ(mvctor_counter, dtor_counter); // only the moved-from originals are destroyed
+        for(int i = 0; i < 8; i++)
+            EXPECT_EQ(i, sut[i].v);
+    }
+    EXPECT_EQ(mvctor_counter + 8, dtor_counter);
+}
+
+TEST(vector, givenElements_whenPushBackOwnElementDuringGrowth_thenValueIsPreserved) {
+    auto sut = stl::vector<int>();
+    sut.push_back(42);
+    sut.push_back(sut[0]); // forces a reallocation while referencing the old buffer
+    sut.push_back(sut[1]);
+    EXPECT_EQ(3, sut.size());
+    EXPECT_EQ(42, sut[2]);
+}
+
+TEST(vector, givenElements_whenResize_thenElementsAreConstructedAndDestroyed) {
+    static int ctor_counter = 0;
+    static int dtor_counter = 0;
+    struct test_struct {
+        test_struct() { ctor_counter++; }
+        ~test_struct() { dtor_counter++; }
+    };
+    auto sut = stl::vector<test_struct>();
+    sut.resize(5);
+    EXPECT_EQ(5, ctor_counter);
+    EXPECT_EQ(5, sut.size());
+    sut.resize(2);
+    EXPECT_EQ(3, dtor_counter);
+    EXPECT_EQ(2, sut.size());
+}
+
+TEST(vector, givenFixedStepGrowth_whenPushBack_thenCapacityGrowsByStep) {
+    auto sut = stl::vector<int, stl::growth::fixed_step<4>>();
+    for(int i = 0; i < 6; i++)
+        sut.push_back(i);
+    EXPECT_EQ(9, sut.capacity()); // 1 -> 5 -> 9
+    EXPECT_EQ(5, sut[5]);
+}
+
+TEST(vector, givenOneAndHalfGrowth_whenPushBack_thenCapacityGrowsByHalf) {
+    auto sut = stl::vector<int, stl::growth::one_and_half>();
+    for(int i = 0; i < 7; i++)
+        sut.push_back(i);
+    EXPECT_EQ(9, sut.capacity()); // 1 -> 2 -> 3 -> 4 -> 6 -> 9
+}
+
+TEST(vector, givenExactFitGrowth_whenPushBack_thenCapacityEqualsSize) {
+    auto sut = stl::vector<int, stl::growth::exact_fit>();
+    for(int i = 0; i < 5; i++) {
+        sut.push_back(i);
+        EXPECT_EQ(sut.size(), sut.capacity());
+    }
+}
+
+TEST(vector, givenSpareCapacity_whenShrinkToFit_thenCapacityEqualsSize) {
+    auto sut = stl::vector<int>();
+    sut.reserve(32);
+    sut.push_back(1);
+    sut.push_back(2);
+    sut.shrink_to_fit();
+    EXPECT_EQ(2, sut.capacity());
+    EXPECT_EQ(1, sut[0]);
+    EXPECT_EQ(2, sut[1]);
+}
+
+TEST(vector, givenSmallSizeType_whenFilledToMax_thenAllElementsFit) {
+    auto sut = stl::vector<uint8_t, stl::growth::doubling, uint8_t>();
+    for(int i = 0; i < 255; i++)
+        sut.push_back(static_cast<uint8_t>(i));
+    EXPECT_EQ(255, sut.size());
+    EXPECT_EQ(255, sut.capacity()); // growth is clamped to what uint8_t can count
+    EXPECT_EQ(254, sut[254]);
+}
+
+// sizeof regressions: one pointer plus two counters of the chosen size type
+static_assert(sizeof(stl::vector<int>) == sizeof(int*) + 2 * sizeof(unsigned int));
+static_assert(sizeof(stl::vector<int, stl::growth::doubling, uint16_t>) ==
+              (sizeof(int*) + 2 * sizeof(uint16_t) + alignof(int*) - 1) / alignof(int*) * alignof(int*));
+static_assert(sizeof(stl::vector<int, stl::growth::doubling, uint8_t>) ==
+              (sizeof(int*) + 2 * sizeof(uint8_t) + alignof(int*) - 1) / alignof(int*) * alignof(int*));
+static_assert(sizeof(stl::vector<int, stl::growth::doubling, uint8_t>) <= sizeof(stl::vector<int>));
+
 #pragma clang diagnostic pop
 #endif